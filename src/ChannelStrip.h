@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "modules/doppler/DopplerEffect.h"
+#include "modules/filter/Crossover.h"
+#include "modules/filter/FilterBank.h"
+#include "modules/filter/LinearPhaseCrossover.h"
+#include "modules/reverb/Reverb.h"
+#include "Parameters.h"
+
+#ifndef DELIRION_PRECISION_REPORT
+#define DELIRION_PRECISION_REPORT 0
+#endif
+
+/**
+ * All processing state of a single channel, allocated as a single cache line aligned object
+ * (rather than a separate heap allocation per module) so rendering a channel walks through
+ * contiguous memory. Members are ordered in order of processing, preceded by the silence
+ * and linked input detection state which is accessed for every tile (even when idle).
+ * The delay memory (recordings and reverb buffers) lives outside of the strip, inside the processors MemorySlab.
+ *
+ * The strip holds the state of the modules rendering in single precision only, the modules rendering in the
+ * precision of the host are held by ChannelEffects (the strips of the processor are ChannelEffects of either type).
+ */
+struct alignas( 64 ) ChannelStrip
+{
+    static const int MAX_BANDS       = Parameters::Config::MAX_BANDS;
+    static const int DISTORTION_BAND = 0; // the lowest band
+    static const int REVERB_BAND     = 1; // the band above the lowest band (e.g. the mid band when using three bands)
+
+    explicit ChannelStrip( double sampleRate ) : linearPhaseState( sampleRate )
+    {
+
+    }
+
+    // silence detection and detection of input identical to the first channel
+
+    int silentSamples = 0;
+    int identicalInputSamples = 0;
+    bool isIdle = false;
+
+    Crossover::State crossoverState; // state of the band splitting filters (see Crossover)
+    LinearPhaseCrossover::State linearPhaseState; // (see LinearPhaseCrossover)
+    FilterBank::State filterState; // state of the band filters (see FilterBank)
+
+    // the location of the delay memory within the slab (page aligned offsets, in floats). The slab reserves
+    // the longest possible recording for each band, of which only the currently used size is committed
+
+    size_t recordMemoryOffsets [ MAX_BANDS ] = {};
+    int    committedRecordSizes[ MAX_BANDS ] = {}; // in samples, managed by the message thread
+    size_t reverbMemoryOffset = 0;
+
+    JUCE_DECLARE_NON_COPYABLE( ChannelStrip )
+};
+
+/**
+ * The effects of a channel strip rendering samples of given type, e.g. double when the host
+ * processes in double precision (the band filters are applied in between, in single precision)
+ */
+template <typename SampleType>
+struct alignas( 64 ) ChannelEffects : ChannelStrip
+{
+    ChannelEffects( double sampleRate, int samplesPerBlock ) :
+        ChannelEffects( sampleRate, samplesPerBlock, std::make_index_sequence<MAX_BANDS>())
+    {
+
+    }
+
+    DopplerEffect<SampleType> dopplerEffects[ MAX_BANDS ];
+    Reverb<SampleType> reverb; // applied onto the REVERB_BAND
+
+    private:
+        template <size_t... Bands>
+        ChannelEffects( double sampleRate, int samplesPerBlock, std::index_sequence<Bands...> ) :
+            ChannelStrip( sampleRate ),
+            dopplerEffects {( static_cast<void>( Bands ), DopplerEffect<SampleType>( sampleRate, samplesPerBlock ))... },
+            reverb( sampleRate, Parameters::Config::REVERB_WIDTH_DEF, Parameters::Config::REVERB_SIZE_DEF )
+        {
+
+        }
+
+    JUCE_DECLARE_NON_COPYABLE( ChannelEffects )
+};
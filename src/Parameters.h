@@ -29,13 +29,29 @@ namespace Parameters {
     static juce::String HI_LFO_EVEN      = "hiLfoEven";
     static juce::String HI_LFO_LINK      = "hiLfoLink";
     static juce::String DISTORTION_MIX   = "distMix";
+    static juce::String DISTORTION_TYPE  = "distType";
+    static juce::String DISTORTION_RATE  = "distRate";
     static juce::String LOW_BAND         = "lowBand";
     static juce::String MID_BAND         = "midBand";
     static juce::String HI_BAND          = "hiBand";
+    static juce::String LOW_BAND_ENABLED = "lowBandEnabled";
+    static juce::String MID_BAND_ENABLED = "midBandEnabled";
+    static juce::String HI_BAND_ENABLED  = "hiBandEnabled";
+    static juce::String LOW_BAND_SOLO    = "lowBandSolo";
+    static juce::String MID_BAND_SOLO    = "midBandSolo";
+    static juce::String HI_BAND_SOLO     = "hiBandSolo";
     static juce::String WET_DRY_MIX      = "wetDryMix";
     static juce::String REVERB_FREEZE    = "reverbFreeze";
     static juce::String INVERT_DIRECTION = "invertDirection";
     static juce::String BEAT_SYNC        = "beatSync";
+    static juce::String LFO_WAVEFORM     = "lfoWaveform";
+    static juce::String BAND_COUNT       = "bandCount";
+    static juce::String CROSSOVER_MODE   = "crossoverMode";
+    static juce::String REVERB_TYPE      = "reverbType";
+
+    // the impulse response file of the convolution reverb is persisted as a property of the state (not automatable)
+
+    static juce::String IMPULSE_RESPONSE = "impulseResponse";
     
     namespace Ranges {
         static float LOW_BAND_MIN = 20.f;
@@ -55,22 +71,68 @@ namespace Parameters {
         
         static float DISTORTION_AMT_DEF = 0.5f;
         static float DISTORTION_WET_DEF = DISTORTION_AMT_DEF;
+        static float DISTORTION_RATE_DEF = 0.f; // sample rate reduction of the bitcrusher
 
         static float LOW_BAND_DEF = 200.f;
         static float MID_BAND_DEF = 1000.f;
         static float HI_BAND_DEF  = 5000.f;
 
+        // the spectrum is divided into a configurable amount of bands. The lowest and highest band are defined
+        // by the low and high band parameters, the bands in between are spread (logarithmically) around the mid band.
+        // The settings of the bands in between are interpolated from the low, mid and high band settings
+
+        static const int MIN_BANDS      = 2;
+        static const int MAX_BANDS      = 8;
+        static const int BAND_COUNT_DEF = 3;
+        static const float MID_BAND_Q   = 1.f; // for the default band count, narrows as bands are added
+
         static float WET_DRY_MIX_DEF = 1.f; // 100 % wet
 
         static float REVERB_WIDTH_DEF  = 0.15f;
         static float REVERB_SIZE_DEF   = 1.f;
         static float REVERB_FREEZE_TIMEOUT = 0.15f; // in seconds
+        static float REVERB_DECAY_DEF  = 2.5f; // in seconds, of the FDN and of the impulse response used when no file was loaded
+        static float REVERB_DAMP_DEF   = 0.2f; // high frequency damping of the FDN
 
         static bool INVERT_DIR_DEF = true;
 
+        // signals below this level (-100 dB) are considered silent, channels which have received
+        // silent input for longer than their tail length are idled until input arrives again
+
+        static const float SILENCE_THRESHOLD = 0.00001f;
+
+        // the processor renders the host provided blocks in tiles of (at most) this amount of samples
+        // so that the intermediate band buffers remain cache resident when hosts provide large blocks
+
+#ifdef DELIRION_TILE_SIZE
+        static const int TILE_SIZE = DELIRION_TILE_SIZE;
+#else
+        static const int TILE_SIZE = 256;
+#endif
+
+        // the Doppler history can be stored in block floating point format (16-bit samples sharing a single
+        // scale per block of 2 ^ HISTORY_BLOCK_SHIFT samples) rather than as floats, halving its memory footprint
+
+#ifdef DELIRION_COMPRESSED_HISTORY
+        static const bool COMPRESS_HISTORY = DELIRION_COMPRESSED_HISTORY;
+#else
+        static const bool COMPRESS_HISTORY = false;
+#endif
+        static const int HISTORY_BLOCK_SHIFT = 5;
+
+        // whether the delay memory is locked into physical memory (when permitted by the system), preventing
+        // the memory of enabled bands from being paged out (and faulted back in on the audio thread)
+
+        static const bool LOCK_DELAY_MEMORY = true;
+
         static const int NUM_COMBS     = 8;
         static const int NUM_ALLPASSES = 4;
         static const int COMB_TUNINGS[ NUM_COMBS ] = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 };
         static const int ALLPASS_TUNINGS[ NUM_ALLPASSES ] = { 556, 441, 341, 225 };
+
+        // delay line lengths of the feedback delay network reverb (mutually prime, in samples at 44.1 kHz)
+
+        static const int NUM_FDN_LINES = 8;
+        static const int FDN_TUNINGS[ NUM_FDN_LINES ] = { 1433, 1601, 1867, 2053, 2251, 2399, 2617, 2897 };
     }
 }
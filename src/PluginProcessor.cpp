@@ -41,21 +41,67 @@ AudioPluginAudioProcessor::AudioPluginAudioProcessor(): AudioProcessor( BusesPro
     hiLfoEven  = parameters.getRawParameterValue( Parameters::HI_LFO_EVEN );
     hiLfoLink  = parameters.getRawParameterValue( Parameters::HI_LFO_LINK );
 
-    distortionMix = parameters.getRawParameterValue( Parameters::DISTORTION_MIX );
+    distortionMix  = parameters.getRawParameterValue( Parameters::DISTORTION_MIX );
+    distortionType = parameters.getRawParameterValue( Parameters::DISTORTION_TYPE );
+    distortionRate = parameters.getRawParameterValue( Parameters::DISTORTION_RATE );
 
     lowBand = parameters.getRawParameterValue( Parameters::LOW_BAND );
     midBand = parameters.getRawParameterValue( Parameters::MID_BAND );
     hiBand  = parameters.getRawParameterValue( Parameters::HI_BAND );
+    bandCount = parameters.getRawParameterValue( Parameters::BAND_COUNT );
+    crossoverMode = parameters.getRawParameterValue( Parameters::CROSSOVER_MODE );
+
+    lowBandEnabled = parameters.getRawParameterValue( Parameters::LOW_BAND_ENABLED );
+    midBandEnabled = parameters.getRawParameterValue( Parameters::MID_BAND_ENABLED );
+    hiBandEnabled  = parameters.getRawParameterValue( Parameters::HI_BAND_ENABLED );
+    lowBandSolo    = parameters.getRawParameterValue( Parameters::LOW_BAND_SOLO );
+    midBandSolo    = parameters.getRawParameterValue( Parameters::MID_BAND_SOLO );
+    hiBandSolo     = parameters.getRawParameterValue( Parameters::HI_BAND_SOLO );
 
     wetDryMix       = parameters.getRawParameterValue( Parameters::WET_DRY_MIX );
     reverbFreeze    = parameters.getRawParameterValue( Parameters::REVERB_FREEZE );
+    reverbType      = parameters.getRawParameterValue( Parameters::REVERB_TYPE );
     invertDirection = parameters.getRawParameterValue( Parameters::INVERT_DIRECTION );
     beatSync        = parameters.getRawParameterValue( Parameters::BEAT_SYNC );
+    lfoWaveform     = parameters.getRawParameterValue( Parameters::LFO_WAVEFORM );
+
+    for ( int band = 0; band < ChannelStrip::MAX_BANDS; ++band ) {
+        bandStates  [ band ].store( BAND_DISABLED );
+        isBandLinked[ band ].store( false );
+    }
+
+#if DELIRION_TRACING
+    tracer = std::make_unique<Tracer>( "delirion_trace" );
+#endif
+
+#if DELIRION_WATCHDOG
+    // the parameter state is logged alongside each deadline overrun
+
+    overrunValueNames = { "load", "samples" };
+
+    for ( auto* parameterId : {
+        &Parameters::LOW_LFO_ODD, &Parameters::LOW_LFO_EVEN, &Parameters::LOW_LFO_LINK,
+        &Parameters::MID_LFO_ODD, &Parameters::MID_LFO_EVEN, &Parameters::MID_LFO_LINK,
+        &Parameters::HI_LFO_ODD,  &Parameters::HI_LFO_EVEN,  &Parameters::HI_LFO_LINK,
+        &Parameters::DISTORTION_MIX, &Parameters::LOW_BAND, &Parameters::MID_BAND, &Parameters::HI_BAND,
+        &Parameters::BAND_COUNT, &Parameters::LOW_BAND_ENABLED, &Parameters::MID_BAND_ENABLED, &Parameters::HI_BAND_ENABLED,
+        &Parameters::LOW_BAND_SOLO, &Parameters::MID_BAND_SOLO, &Parameters::HI_BAND_SOLO,
+        &Parameters::WET_DRY_MIX, &Parameters::REVERB_FREEZE, &Parameters::INVERT_DIRECTION, &Parameters::BEAT_SYNC,
+        &Parameters::LFO_WAVEFORM, &Parameters::CROSSOVER_MODE, &Parameters::REVERB_TYPE,
+        &Parameters::DISTORTION_TYPE, &Parameters::DISTORTION_RATE
+    }) {
+        overrunValueNames.push_back( parameterId->toRawUTF8());
+        watchedParameters.push_back( parameters.getRawParameterValue( *parameterId ));
+    }
+    jassert( static_cast<int>( overrunValueNames.size()) <= Debug::MAX_VALUES );
+#endif
 }
 
 AudioPluginAudioProcessor::~AudioPluginAudioProcessor()
 {
-    // nowt...
+    // hosts aren't required to release the resources prior to destroying the processor
+
+    releaseResources();
 }
 
 /* configuration */
@@ -115,7 +161,15 @@ bool AudioPluginAudioProcessor::isMidiEffect() const
 
 double AudioPluginAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    if ( *reverbFreeze >= 0.5f ) {
+        return std::numeric_limits<double>::infinity(); // frozen reverb rings on indefinitely
+    }
+    return tailLengthSeconds;
+}
+
+bool AudioPluginAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
 }
 
 /* programs */
@@ -151,37 +205,338 @@ void AudioPluginAudioProcessor::changeProgramName( int index, const juce::String
 
 void AudioPluginAudioProcessor::updateParameters()
 {
-    // bitCrusher->setAmount( *distortionMix );
-    // bitCrusher->setOutputMix( *distortionMix );
+    if ( waveShaper == nullptr ) {
+        return; // hosts can restore state before preparing for playback, values are applied in prepareToPlay()
+    }
+
+    bitCrusher->setAmount( *distortionMix );
+    bitCrusher->setOutputMix( *distortionMix );
+    bitCrusher->setDownsampling( *distortionRate );
     waveShaper->setAmount( *distortionMix );
     waveShaper->setLevel( *distortionMix );
+    doubleWaveShaper->setAmount( *distortionMix );
+    doubleWaveShaper->setLevel( *distortionMix );
 
-    int channelAmount = getTotalNumOutputChannels();
-
-    bool linkLow = *lowLfoLink >= 0.5f;
-    bool linkMid = *midLfoLink >= 0.5f;
-    bool linkHi  = *hiLfoLink  >= 0.5f;
     bool freeze  = *reverbFreeze >= 0.5f;
     bool invert  = *invertDirection >= 0.5f;
     bool sync    = *beatSync >= 0.5f && invert; // @todo sync glitchy on non-inverted Dopplers
- 
-    for ( int channel = 0; channel < channelAmount; ++channel ) {
-        bool isOddChannel = channel % 2 == 0;
+    int waveform = juce::roundToInt( lfoWaveform->load());
+
+    // the even channels use the odd channels LFO speed when linked
+
+    float lowEven = *lowLfoLink >= 0.5f ? lowLfoOdd->load() : lowLfoEven->load();
+    float midEven = *midLfoLink >= 0.5f ? midLfoOdd->load() : midLfoEven->load();
+    float hiEven  = *hiLfoLink  >= 0.5f ? hiLfoOdd->load()  : hiLfoEven->load();
+
+    int numBands = getNumBands();
+    float midBandQ = Parameters::Config::MID_BAND_Q * static_cast<float>( numBands - 1 ) / static_cast<float>( Parameters::Config::BAND_COUNT_DEF - 1 );
+
+    juce::IIRCoefficients coefficients[ ChannelStrip::MAX_BANDS ];
+    float frequencies[ ChannelStrip::MAX_BANDS ];
+
+    for ( int band = 0; band < numBands; ++band ) {
+        float position  = getBandPosition( band, numBands );
+        float frequency = interpolateBandValue( position, *lowBand, *midBand, *hiBand, true );
+        frequencies[ band ] = frequency;
+        float oddSpeed  = interpolateBandValue( position, *lowLfoOdd, *midLfoOdd, *hiLfoOdd, false );
+        float evenSpeed = interpolateBandValue( position, lowEven, midEven, hiEven, false );
+
+        int channel = 0;
+
+        forEachStrip( [ & ]( auto* strip ) {
+            bool isOddChannel = channel++ % 2 == 0;
+            strip->dopplerEffects[ band ].setProperties( isOddChannel ? oddSpeed : evenSpeed, invert, sync );
+        });
+        isBandLinked[ band ].store( juce::exactlyEqual( oddSpeed, evenSpeed ));
+
+        switch ( getBandRole( band, numBands )) {
+            case ROLE_LOW:
+                coefficients[ band ] = juce::IIRCoefficients::makeLowPass( _sampleRate, frequency );
+                break;
+            case ROLE_MID:
+                coefficients[ band ] = juce::IIRCoefficients::makeBandPass( _sampleRate, frequency, midBandQ );
+                break;
+            case ROLE_HI:
+                coefficients[ band ] = juce::IIRCoefficients::makeHighPass( _sampleRate, frequency );
+                break;
+        }
+    }
+    // (bands beyond the band count keep their settings while they fade out)
 
-        lowDopplerEffects[ channel ]->setProperties( linkLow || isOddChannel ? *lowLfoOdd : *lowLfoEven, invert, sync );
-        midDopplerEffects[ channel ]->setProperties( linkMid || isOddChannel ? *midLfoOdd : *midLfoEven, invert, sync );
-        hiDopplerEffects [ channel ]->setProperties( linkHi  || isOddChannel ? *hiLfoOdd  : *hiLfoEven,  invert, sync );
+    filterBank.setCoefficients( coefficients, numBands );
 
-        reverbs[ channel ]->setWet( freeze ? 2.f : 0.f ); // make louder when frozen
-        reverbs[ channel ]->setDry( freeze ? 0.f : 1.f  );
-        reverbs[ channel ]->setMode( freeze ? 1 : 0 );
+    // the crossover splits below the low band frequency and above the high band frequency (matching the corner
+    // frequencies of the post filters), the bands in between are split halfway (logarithmically) between their centers
 
-        // TODO check whether this is expensive and cache the last created coefficients
+    float splitFrequencies[ Crossover::MAX_SPLITS ];
 
-        lowPassFilters [ channel ]->setCoefficients( juce::IIRCoefficients::makeLowPass ( _sampleRate, *lowBand ));
-        bandPassFilters[ channel ]->setCoefficients( juce::IIRCoefficients::makeBandPass( _sampleRate, *midBand, 1.0 ));
-        highPassFilters[ channel ]->setCoefficients( juce::IIRCoefficients::makeHighPass( _sampleRate, *hiBand ));
+    for ( int split = 0; split < numBands - 1; ++split ) {
+        if ( numBands == 2 ) {
+            splitFrequencies[ split ] = std::sqrt( frequencies[ 0 ] * frequencies[ 1 ]);
+        } else if ( split == 0 ) {
+            splitFrequencies[ split ] = frequencies[ 0 ];
+        } else if ( split == numBands - 2 ) {
+            splitFrequencies[ split ] = frequencies[ numBands - 1 ];
+        } else {
+            splitFrequencies[ split ] = std::sqrt( frequencies[ split ] * frequencies[ split + 1 ]);
+        }
     }
+    crossover.setFrequencies( splitFrequencies, numBands - 1, _sampleRate );
+
+    // the linear phase masks are only designed when used (e.g. when switching to the linear phase mode)
+
+    int mode = juce::roundToInt( crossoverMode->load());
+
+    if ( mode == CROSSOVER_LINEAR_PHASE ) {
+        linearPhaseCrossover->setFrequencies( splitFrequencies, numBands - 1 );
+    }
+    int latencySamples = mode == CROSSOVER_LINEAR_PHASE ? linearPhaseCrossover->getLatency() : 0;
+
+    if ( latencySamples != getLatencySamples()) {
+        setLatencySamples( latencySamples );
+    }
+
+    forEachStrip( [ & ]( auto* strip ) {
+        for ( auto& dopplerEffect : strip->dopplerEffects ) {
+            dopplerEffect.setWaveform( waveform );
+        }
+        strip->reverb.setWet( freeze ? 2.f : 0.f ); // make louder when frozen
+        strip->reverb.setDry( freeze ? 0.f : 1.f  );
+        strip->reverb.setMode( freeze ? 1 : 0 );
+    });
+    // (the convolution and FDN reverbs are shared by all strips)
+
+    convolutionReverb->setWet( freeze ? 2.f : 0.f );
+    convolutionReverb->setDry( freeze ? 0.f : 1.f  );
+    convolutionReverb->setMode( freeze ? ConvolutionReverb::FREEZE_MODE : ConvolutionReverb::INITIAL_MODE );
+
+    fdnReverb->setWet( freeze ? 2.f : 0.f );
+    fdnReverb->setDry( freeze ? 0.f : 1.f  );
+    fdnReverb->setMode( freeze ? FdnReverb::FREEZE_MODE : FdnReverb::INITIAL_MODE );
+
+    updateBandStates();
+    resizeRecordings();
+}
+
+/* band layout */
+
+int AudioPluginAudioProcessor::getNumBands()
+{
+    return juce::jlimit( Parameters::Config::MIN_BANDS, Parameters::Config::MAX_BANDS, juce::roundToInt( bandCount->load()));
+}
+
+/* band activation */
+
+bool AudioPluginAudioProcessor::isBandEnabled( int band )
+{
+    int numBands = getNumBands();
+
+    if ( band >= numBands ) {
+        return false;
+    }
+    bool hasMidBand = numBands > 2;
+    bool hasSolo    = *lowBandSolo >= 0.5f || ( hasMidBand && *midBandSolo >= 0.5f ) || *hiBandSolo >= 0.5f;
+
+    switch ( getBandRole( band, numBands )) {
+        default:
+        case ROLE_LOW:
+            return *lowBandEnabled >= 0.5f && ( !hasSolo || *lowBandSolo >= 0.5f );
+        case ROLE_MID:
+            return *midBandEnabled >= 0.5f && ( !hasSolo || *midBandSolo >= 0.5f );
+        case ROLE_HI:
+            return *hiBandEnabled >= 0.5f && ( !hasSolo || *hiBandSolo >= 0.5f );
+    }
+}
+
+void AudioPluginAudioProcessor::updateBandStates()
+{
+    const juce::ScopedLock lock( bandAllocationLock );
+
+    for ( int band = 0; band < ChannelStrip::MAX_BANDS; ++band ) {
+        int state = bandStates[ band ].load();
+
+        if ( isBandEnabled( band )) {
+            if ( state == BAND_DISABLED ) {
+                if ( allocateBand( band )) {
+                    bandStates[ band ].store( BAND_ENABLING );
+                }
+            } else if ( state == BAND_DISABLING && !bandStates[ band ].compare_exchange_strong( state, BAND_ENABLED )) {
+                // audio thread has stopped rendering the band in the meantime, its memory is still allocated
+                bandStates[ band ].store( BAND_ENABLING );
+            } else if ( state == BAND_RELEASABLE ) {
+                bandStates[ band ].store( BAND_ENABLING );
+            }
+        } else {
+            if ( state == BAND_ENABLING ) {
+                if ( bandStates[ band ].compare_exchange_strong( state, BAND_DISABLED )) {
+                    releaseBand( band ); // audio thread never picked up the band
+                    continue;
+                }
+                // audio thread picked up the band in the meantime (state is now BAND_ENABLED)
+            }
+            if ( state == BAND_ENABLED ) {
+                bandStates[ band ].store( BAND_DISABLING ); // released by the timer once acknowledged
+            }
+        }
+    }
+}
+
+bool AudioPluginAudioProcessor::allocateBand( int band )
+{
+    // committing fails when the system is out of memory (e.g. exceeding the commit limit on Windows), in which
+    // case the memory committed for the other strips is released again and the band remains disabled
+
+    bool isAllocated = true;
+
+    forEachStrip( [ & ]( auto* strip ) {
+        if ( !isAllocated ) {
+            return;
+        }
+        auto& dopplerEffect = strip->dopplerEffects[ band ];
+        int recordSize      = dopplerEffect.getRequiredRecordSize();
+        float* reverbMemory = nullptr;
+
+        if ( band == ChannelStrip::REVERB_BAND ) {
+            reverbMemory = delayMemory.commit( strip->reverbMemoryOffset, strip->reverb.getMemorySize());
+            isAllocated  = reverbMemory != nullptr;
+        }
+        float* recordMemory = isAllocated ? delayMemory.commit( strip->recordMemoryOffsets[ band ], dopplerEffect.getMemorySize( recordSize )) : nullptr;
+
+        if ( recordMemory == nullptr ) {
+            if ( reverbMemory != nullptr ) {
+                delayMemory.decommit( strip->reverbMemoryOffset, strip->reverb.getMemorySize());
+            }
+            isAllocated = false;
+            return;
+        }
+        dopplerEffect.allocate( recordMemory, recordSize );
+        strip->committedRecordSizes[ band ] = recordSize;
+
+        if ( reverbMemory != nullptr ) {
+            strip->reverb.allocate( reverbMemory );
+        }
+    });
+
+    if ( !isAllocated ) {
+        releaseBand( band );
+    }
+    return isAllocated;
+}
+
+void AudioPluginAudioProcessor::releaseBand( int band )
+{
+    forEachStrip( [ & ]( auto* strip ) {
+        if ( strip->committedRecordSizes[ band ] == 0 ) {
+            return; // the memory of the strip wasn't committed (see allocateBand())
+        }
+        auto& dopplerEffect = strip->dopplerEffects[ band ];
+
+        dopplerEffect.release();
+        delayMemory.decommit( strip->recordMemoryOffsets[ band ], dopplerEffect.getMemorySize( strip->committedRecordSizes[ band ]));
+        strip->committedRecordSizes[ band ] = 0;
+
+        if ( band == ChannelStrip::REVERB_BAND ) {
+            strip->reverb.release();
+            delayMemory.decommit( strip->reverbMemoryOffset, strip->reverb.getMemorySize());
+        }
+    });
+}
+
+void AudioPluginAudioProcessor::resizeRecordings()
+{
+    const juce::ScopedLock lock( bandAllocationLock );
+
+    for ( int band = 0; band < ChannelStrip::MAX_BANDS; ++band ) {
+        int state = bandStates[ band ].load();
+
+        if ( state != BAND_ENABLING && state != BAND_ENABLED ) {
+            continue; // memory isn't committed or about to be released
+        }
+
+        forEachStrip( [ & ]( auto* strip ) {
+            auto& dopplerEffect = strip->dopplerEffects[ band ];
+            int& committedSize  = strip->committedRecordSizes[ band ];
+            int requiredSize    = dopplerEffect.getRequiredRecordSize();
+            size_t offset       = strip->recordMemoryOffsets[ band ];
+            size_t committed    = MemorySlab::alignToPage( dopplerEffect.getMemorySize( committedSize ));
+            size_t required     = MemorySlab::alignToPage( dopplerEffect.getMemorySize( requiredSize ));
+
+            if ( requiredSize > committedSize ) {
+                // grow the memory before the effect can apply the new size (when the memory
+                // can't be committed, the effect keeps its current size until the next attempt)
+
+                if ( required > committed && delayMemory.commit( offset + committed, required - committed ) == nullptr ) {
+                    return;
+                }
+                committedSize = requiredSize;
+            }
+            dopplerEffect.requestRecordSize( requiredSize );
+
+            if ( requiredSize < committedSize && dopplerEffect.isRecordSizeApplied()) {
+                // the effect no longer reads beyond the required size, shrink the memory
+
+                if ( required < committed ) {
+                    delayMemory.decommit( offset + required, committed - required );
+                }
+                committedSize = requiredSize;
+            }
+        });
+    }
+}
+
+void AudioPluginAudioProcessor::acquireBands()
+{
+    for ( int band = 0; band < ChannelStrip::MAX_BANDS; ++band ) {
+        int state = bandStates[ band ].load();
+
+        isBandRendered[ band ] = true;
+        bandStartGain [ band ] = 1.f;
+        bandEndGain   [ band ] = 1.f;
+
+        if ( state == BAND_ENABLING && bandStates[ band ].compare_exchange_strong( state, BAND_ENABLED )) {
+            // band has just been allocated, align its recording with the timeline and fade it in
+            // (its memory has been zeroed when committed, so the recording isn't cleared on this thread)
+
+            forEachStrip( [ & ]( auto* strip ) {
+                strip->dopplerEffects[ band ].updateTempo( tempo, timeSigNumerator, timeSigDenominator );
+                strip->filterState.reset( band );
+                strip->linearPhaseState.reset( band );
+            });
+            bandStartGain[ band ] = 0.f;
+        } else if ( state == BAND_DISABLING ) {
+            bandEndGain[ band ] = 0.f; // fade out, rendering stops after this block
+        } else if ( state != BAND_ENABLED ) {
+            isBandRendered[ band ] = false;
+        }
+    }
+}
+
+void AudioPluginAudioProcessor::acknowledgeBands()
+{
+    for ( int band = 0; band < ChannelStrip::MAX_BANDS; ++band ) {
+        int expected = BAND_DISABLING;
+
+        if ( isBandRendered[ band ] && bandEndGain[ band ] == 0.f ) {
+            bandStates[ band ].compare_exchange_strong( expected, BAND_RELEASABLE );
+        }
+    }
+}
+
+void AudioPluginAudioProcessor::timerCallback()
+{
+    {
+        const juce::ScopedLock lock( bandAllocationLock );
+
+        for ( int band = 0; band < ChannelStrip::MAX_BANDS; ++band ) {
+            if ( bandStates[ band ].load() == BAND_RELEASABLE ) {
+                releaseBand( band );
+                bandStates[ band ].store( BAND_DISABLED );
+            }
+        }
+    }
+    // the required recording sizes also change with the tempo (when synced), which is only known to the audio thread
+
+    resizeRecordings();
 }
 
 /* resource management */
@@ -195,123 +550,883 @@ void AudioPluginAudioProcessor::prepareToPlay( double sampleRate, int samplesPer
 
     int channelAmount = getTotalNumOutputChannels();
 
+    // the effects render in the precision requested by the host (set prior to preparing)
+
+    bool isDoublePrecision = isUsingDoublePrecision();
+
     for ( int i = 0; i < channelAmount; ++i )
     {
-        lowPassFilters.add ( new juce::IIRFilter());
-        bandPassFilters.add( new juce::IIRFilter());
-        highPassFilters.add( new juce::IIRFilter());
+        if ( isDoublePrecision ) {
+            doubleChannelStrips.add( new ChannelEffects<double>( sampleRate, samplesPerBlock ));
+        } else {
+            channelStrips.add( new ChannelEffects<float>( sampleRate, samplesPerBlock ));
+        }
+    }
+
+    forEachStrip( [ & ]( auto* strip ) {
+        // sync with the last known tempo (as the host might not report a change in tempo when preparing mid-session)
+
+        for ( auto& dopplerEffect : strip->dopplerEffects ) {
+            dopplerEffect.updateTempo( tempo, timeSigNumerator, timeSigDenominator );
+        }
+        tailLengthSeconds = strip->dopplerEffects[ 0 ].getTailLength(); // equal for all strips
+    });
+
+    if ( isDoublePrecision ) {
+        doubleBandBuffers.setSize ( ChannelStrip::MAX_BANDS, Parameters::Config::TILE_SIZE );
+        doubleLinkedBuffer.setSize( ChannelStrip::MAX_BANDS, Parameters::Config::TILE_SIZE );
+        singlePrecisionBuffer.setSize( ChannelStrip::MAX_BANDS + 1, Parameters::Config::TILE_SIZE );
+    } else {
+        bandBuffers.setSize ( ChannelStrip::MAX_BANDS, Parameters::Config::TILE_SIZE );
+        linkedBuffer.setSize( ChannelStrip::MAX_BANDS, Parameters::Config::TILE_SIZE );
+    }
+
+    if ( channelAmount > 0 ) {
+        idleAfterSamples = static_cast<int>( std::ceil( tailLengthSeconds * sampleRate ));
+    }
+
+    // lay out the delay memory of all strips within a single slab and commit the memory of the enabled bands
+    // (the effects are constructed without memory, they receive it once their band is allocated)
+
+    {
+        const juce::ScopedLock lock( bandAllocationLock );
+
+        size_t slabSize = 0;
+
+        forEachStrip( [ & ]( auto* strip ) {
+            for ( int band = 0; band < ChannelStrip::MAX_BANDS; ++band ) {
+                strip->recordMemoryOffsets[ band ] = slabSize;
+                slabSize += MemorySlab::alignToPage( strip->dopplerEffects[ band ].getMemorySize());
+            }
+            strip->reverbMemoryOffset = slabSize;
+            slabSize += MemorySlab::alignToPage( strip->reverb.getMemorySize());
+        });
 
-        lowPassFilters [ i ]->setCoefficients( juce::IIRCoefficients::makeLowPass ( sampleRate, Parameters::Config::LOW_BAND_DEF ));
-        bandPassFilters[ i ]->setCoefficients( juce::IIRCoefficients::makeBandPass( sampleRate, Parameters::Config::MID_BAND_DEF, 1.0 ));
-        highPassFilters[ i ]->setCoefficients( juce::IIRCoefficients::makeHighPass( sampleRate, Parameters::Config::HI_BAND_DEF ));
+        // exceptions must not leave the host callback. When the address range can't be reserved, no memory can be
+        // committed so the bands remain disabled (until reserving succeeds when preparing again)
 
-        lowDopplerEffects.add( new DopplerEffect( sampleRate, samplesPerBlock ));
-        midDopplerEffects.add( new DopplerEffect( sampleRate, samplesPerBlock ));
-        hiDopplerEffects.add ( new DopplerEffect( sampleRate, samplesPerBlock ));
+        if ( !delayMemory.reserve( slabSize, Parameters::Config::LOCK_DELAY_MEMORY )) {
+            DBG( "Delirion: could not reserve " << static_cast<juce::int64>( slabSize * sizeof( float )) << " bytes of delay memory, the bands remain disabled" );
+        }
+
+        for ( int band = 0; band < ChannelStrip::MAX_BANDS; ++band ) {
+            if ( isBandEnabled( band ) && allocateBand( band )) {
+                bandStates[ band ].store( BAND_ENABLED );
+            } else {
+                bandStates[ band ].store( BAND_DISABLED );
+            }
+        }
 
-        reverbs.add( new Reverb( sampleRate, Parameters::Config::REVERB_WIDTH_DEF, Parameters::Config::REVERB_SIZE_DEF ));
+        DBG( "Delirion: reserved " << static_cast<juce::int64>( delayMemory.getReservedBytes()) << " bytes of delay memory, "
+             << static_cast<juce::int64>( delayMemory.getCommittedBytes()) << " bytes committed"
+             << ( delayMemory.isLocked() ? " and locked" : "" ));
     }
-    // bitCrusher = new BitCrusher( Parameters::Config::DISTORTION_AMT_DEF, 1.f, Parameters::Config::DISTORTION_WET_DEF );
-    waveShaper = new WaveShaper( Parameters::Config::DISTORTION_AMT_DEF, Parameters::Config::DISTORTION_WET_DEF );
-    
+
+    linearPhaseCrossover = std::make_unique<LinearPhaseCrossover>( sampleRate );
+
+    convolutionReverb = std::make_unique<ConvolutionReverb>( sampleRate, channelAmount );
+    convolutionReverb->setImpulseResponse( createImpulseResponse());
+    fdnReverb = std::make_unique<FdnReverb>( sampleRate, Parameters::Config::REVERB_DECAY_DEF, Parameters::Config::REVERB_DAMP_DEF );
+
+    bitCrusher = new BitCrusher( Parameters::Config::DISTORTION_AMT_DEF, 1.f, Parameters::Config::DISTORTION_WET_DEF, channelAmount );
+    waveShaper = new WaveShaper<float>( Parameters::Config::DISTORTION_AMT_DEF, Parameters::Config::DISTORTION_WET_DEF );
+    doubleWaveShaper = new WaveShaper<double>( Parameters::Config::DISTORTION_AMT_DEF, Parameters::Config::DISTORTION_WET_DEF );
+
+    // select the kernels for the instruction set of the CPU (up to the maximum level)
+
+    applySimdLevel( std::min( Simd::detectLevel(), maxSimdLevel ));
+
+    DBG( "Delirion: rendering using " << Simd::getLevelName( simdLevel ) << " kernels in " << ( isDoublePrecision ? "double" : "single" ) << " precision" );
+
+#if DELIRION_SIMD_REPORT
+    reportSimdLevels();
+#endif
+
+#if DELIRION_PRECISION_REPORT
+    reportPrecision();
+#endif
+
     // align values with model
     updateParameters();
+
+    startTimer( MEMORY_UPDATE_INTERVAL_MS );
 }
 
 void AudioPluginAudioProcessor::releaseResources()
 {
-    lowPassFilters.clear();
-    bandPassFilters.clear();
-    highPassFilters.clear();
+    stopTimer();
 
-    lowDopplerEffects.clear();
-    midDopplerEffects.clear();
-    hiDopplerEffects.clear();
+    const juce::ScopedLock lock( bandAllocationLock );
+
+    for ( auto& bandState : bandStates ) {
+        bandState.store( BAND_DISABLED );
+    }
 
-    reverbs.clear();
+    channelStrips.clear();
+    doubleChannelStrips.clear();
+    delayMemory.release();
+    convolutionReverb.reset(); // (stops its background thread)
+    fdnReverb.reset();
 
-    // if ( bitCrusher != nullptr ) {
-    //     delete bitCrusher;
-    //     bitCrusher = nullptr;
-    // }
+    if ( bitCrusher != nullptr ) {
+        delete bitCrusher;
+        bitCrusher = nullptr;
+    }
     if ( waveShaper != nullptr ) {
         delete waveShaper;
         waveShaper = nullptr;
     }
+    if ( doubleWaveShaper != nullptr ) {
+        delete doubleWaveShaper;
+        doubleWaveShaper = nullptr;
+    }
+}
+
+size_t AudioPluginAudioProcessor::getDelayMemorySize() const
+{
+    return delayMemory.getReservedBytes();
+}
+
+size_t AudioPluginAudioProcessor::getCommittedDelayMemorySize() const
+{
+    return delayMemory.getCommittedBytes();
+}
+
+void AudioPluginAudioProcessor::setMaxSimdLevel( int level )
+{
+    maxSimdLevel = level;
+}
+
+void AudioPluginAudioProcessor::setMaxTileSize( int size )
+{
+    maxTileSize = juce::jlimit( 1, Parameters::Config::TILE_SIZE, size );
+}
+
+void AudioPluginAudioProcessor::applySimdLevel( int level )
+{
+    simdLevel = level;
+
+    filterBank.setSimdLevel( level );
+    crossover.setSimdLevel( level );
+    fdnReverb->setSimdLevel( level );
+    waveShaper->setSimdLevel( level );
+    doubleWaveShaper->setSimdLevel( level );
+
+    // (the Doppler effect is bound by its scattered history reads and gains nothing from wider vectors)
+
+    forEachStrip( [ & ]( auto* strip ) {
+        strip->reverb.setSimdLevel( level );
+    });
+    mixVariant = Simd::select<MixVariant>( level, &AudioPluginAudioProcessor::mixTileBaseline,
+                                           &AudioPluginAudioProcessor::mixTileAvx2, &AudioPluginAudioProcessor::mixTileAvx512 );
 }
 
+#if DELIRION_SIMD_REPORT
+void AudioPluginAudioProcessor::reportSimdLevels()
+{
+    // each kernel renders a tile of noise on a scratch instance (so the state of the processor is left untouched)
+
+    const int tileSize   = Parameters::Config::TILE_SIZE;
+    const int iterations = 2000;
+
+    juce::AudioBuffer<float> input ( FilterBank::MAX_LANES, tileSize );
+    juce::AudioBuffer<float> output( FilterBank::MAX_LANES, tileSize );
+    juce::Random random( 1234 );
+
+    for ( int lane = 0; lane < input.getNumChannels(); ++lane ) {
+        for ( int i = 0; i < tileSize; ++i ) {
+            input.setSample( lane, i, random.nextFloat() * 2.f - 1.f );
+        }
+    }
+
+    // measures the duration of a tile (in ns per sample) for all supported levels, relative to the baseline level
+
+    auto report = [ & ]( const char* name, const std::function<void( int )>& setLevel, const std::function<void()>& render )
+    {
+        double baseline = 0.0;
+
+        for ( int level = Simd::LEVEL_BASELINE; level < Simd::NUM_LEVELS; ++level ) {
+            if ( !Simd::isSupported( level )) {
+                continue;
+            }
+            setLevel( level );
+
+            // the fastest tile is reported, as it is least affected by other activity on the system
+
+            double seconds = std::numeric_limits<double>::max();
+
+            for ( int i = 0; i < iterations; ++i ) {
+                output.makeCopyOf( input, true );
+
+                auto start = juce::Time::getHighResolutionTicks();
+                render();
+                seconds = std::min( seconds, juce::Time::highResolutionTicksToSeconds( juce::Time::getHighResolutionTicks() - start ));
+            }
+            double duration = seconds * 1e9 / static_cast<double>( tileSize );
+
+            if ( level == Simd::LEVEL_BASELINE ) {
+                baseline = duration;
+            }
+            juce::Logger::writeToLog( juce::String( "Delirion: " ) + name + " (" + Simd::getLevelName( level ) + "): "
+                                      + juce::String( duration, 2 ) + " ns/sample, " + juce::String( baseline / duration, 2 ) + "x" );
+        }
+        setLevel( simdLevel );
+    };
+
+    FilterBank bands( 2 );
+    FilterBank::State bandState;
+    std::vector<juce::IIRCoefficients> coefficients;
+
+    for ( int lane = 0; lane < FilterBank::MAX_LANES; ++lane ) {
+        for ( int stage = 0; stage < 2; ++stage ) {
+            coefficients.push_back( juce::IIRCoefficients::makeLowPass( _sampleRate, 200.0 * ( lane + 1 )));
+        }
+    }
+    bands.setCoefficients( coefficients.data(), FilterBank::MAX_LANES );
+
+    report( "band filters", [ & ]( int level ) { bands.setSimdLevel( level ); }, [ & ] {
+        bands.process( bandState, output.getArrayOfWritePointers(), FilterBank::MAX_LANES, tileSize );
+    });
+
+    Reverb<float> reverb( _sampleRate, Parameters::Config::REVERB_WIDTH_DEF, Parameters::Config::REVERB_SIZE_DEF );
+    std::vector<float> reverbMemory( reverb.getMemorySize(), 0.f );
+    reverb.allocate( reverbMemory.data());
+    reverb.setWet( 1.f );
+
+    report( "reverb", [ & ]( int level ) { reverb.setSimdLevel( level ); }, [ & ] {
+        reverb.apply( output.getWritePointer( 0 ), tileSize );
+    });
+
+    FdnReverb fdn( _sampleRate, Parameters::Config::REVERB_DECAY_DEF, Parameters::Config::REVERB_DAMP_DEF );
+    fdn.setWet( 1.f );
+
+    report( "FDN reverb", [ & ]( int level ) { fdn.setSimdLevel( level ); }, [ & ] {
+        fdn.apply( 0, output.getWritePointer( 0 ), tileSize );
+        fdn.apply( 1, output.getWritePointer( 1 ), tileSize );
+        fdn.advance( tileSize );
+    });
+
+    WaveShaper<float> shaper( Parameters::Config::DISTORTION_AMT_DEF, 1.f );
+
+    report( "waveshaper", [ & ]( int level ) { shaper.setSimdLevel( level ); }, [ & ] {
+        shaper.apply( output.getWritePointer( 0 ), tileSize );
+    });
+
+    // the band mix (without fused distortion, as the mix state belongs to the processor)
+
+    bool renderedBands[ ChannelStrip::MAX_BANDS ];
+    std::copy_n( isBandRendered, ChannelStrip::MAX_BANDS, renderedBands );
+    std::fill_n( isBandRendered, ChannelStrip::MAX_BANDS, true );
+
+    float startGains[ ChannelStrip::MAX_BANDS ];
+    float endGains  [ ChannelStrip::MAX_BANDS ];
+    std::fill_n( startGains, ChannelStrip::MAX_BANDS, 0.5f );
+    std::fill_n( endGains,   ChannelStrip::MAX_BANDS, 1.f );
+
+    MixVariant activeMix = mixVariant;
+
+    report( "band mix", [ & ]( int level ) {
+        mixVariant = Simd::select<MixVariant>( level, &AudioPluginAudioProcessor::mixTileBaseline,
+                                               &AudioPluginAudioProcessor::mixTileAvx2, &AudioPluginAudioProcessor::mixTileAvx512 );
+    }, [ & ] {
+        ( this->*mixVariant )({ output.getWritePointer( 0 ), output.getArrayOfWritePointers() + 1, startGains, endGains,
+                                 ChannelStrip::MAX_BANDS - 1, -1, false, 0.5f, 0.5f, tileSize });
+    });
+    mixVariant = activeMix;
+    std::copy_n( renderedBands, ChannelStrip::MAX_BANDS, isBandRendered );
+}
+#endif
+
+#if DELIRION_PRECISION_REPORT
+void AudioPluginAudioProcessor::reportPrecision()
+{
+    // each effect renders a tile of noise in both precisions on scratch instances (as in reportSimdLevels())
+
+    const int tileSize   = Parameters::Config::TILE_SIZE;
+    const int iterations = 2000;
+
+    juce::AudioBuffer<float>  singleInput ( 1, tileSize ), singleOutput( 1, tileSize );
+    juce::AudioBuffer<double> doubleInput ( 1, tileSize ), doubleOutput( 1, tileSize );
+    juce::Random random( 1234 );
+
+    for ( int i = 0; i < tileSize; ++i ) {
+        float value = random.nextFloat() * 2.f - 1.f;
+        singleInput.setSample( 0, i, value );
+        doubleInput.setSample( 0, i, value );
+    }
+
+    // the fastest tile (in ns per sample), as it is least affected by other activity on the system
+
+    auto measure = [ & ]( const auto& input, auto& output, const auto& render )
+    {
+        double seconds = std::numeric_limits<double>::max();
+
+        for ( int i = 0; i < iterations; ++i ) {
+            output.makeCopyOf( input, true );
+
+            auto start = juce::Time::getHighResolutionTicks();
+            render( output.getWritePointer( 0 ));
+            seconds = std::min( seconds, juce::Time::highResolutionTicksToSeconds( juce::Time::getHighResolutionTicks() - start ));
+        }
+        return seconds * 1e9 / static_cast<double>( tileSize );
+    };
+
+    auto report = [ & ]( const char* name, const auto& renderSingle, const auto& renderDouble )
+    {
+        double single  = measure( singleInput, singleOutput, renderSingle );
+        double precise = measure( doubleInput, doubleOutput, renderDouble );
+
+        juce::Logger::writeToLog( juce::String( "Delirion: " ) + name + ": " + juce::String( single, 2 ) + " ns/sample in single precision, "
+                                  + juce::String( precise, 2 ) + " ns/sample in double precision (" + juce::String( precise / single, 2 ) + "x)" );
+    };
+
+    DopplerEffect<float>  singleDoppler( _sampleRate, tileSize );
+    DopplerEffect<double> doubleDoppler( _sampleRate, tileSize );
+    std::vector<float> singleRecording, doubleRecording;
+
+    auto prepareDoppler = [ & ]( auto& dopplerEffect, std::vector<float>& memory )
+    {
+        dopplerEffect.setProperties( 0.5f, true, false );
+        memory.resize( dopplerEffect.getMemorySize(), 0.f );
+        dopplerEffect.allocate( memory.data(), dopplerEffect.getRequiredRecordSize());
+        dopplerEffect.updateTempo( tempo, timeSigNumerator, timeSigDenominator );
+    };
+    prepareDoppler( singleDoppler, singleRecording );
+    prepareDoppler( doubleDoppler, doubleRecording );
+
+    report( "Doppler", [ & ]( float* data ) { singleDoppler.apply( data, tileSize ); }, [ & ]( double* data ) { doubleDoppler.apply( data, tileSize ); });
+
+    Reverb<float>  singleReverb( _sampleRate, Parameters::Config::REVERB_WIDTH_DEF, Parameters::Config::REVERB_SIZE_DEF );
+    Reverb<double> doubleReverb( _sampleRate, Parameters::Config::REVERB_WIDTH_DEF, Parameters::Config::REVERB_SIZE_DEF );
+    std::vector<float> singleReverbMemory( singleReverb.getMemorySize(), 0.f );
+    std::vector<float> doubleReverbMemory( doubleReverb.getMemorySize(), 0.f );
+
+    singleReverb.allocate( singleReverbMemory.data());
+    doubleReverb.allocate( doubleReverbMemory.data());
+    singleReverb.setSimdLevel( simdLevel );
+    doubleReverb.setSimdLevel( simdLevel );
+    singleReverb.setWet( 1.f );
+    doubleReverb.setWet( 1.f );
+
+    report( "reverb", [ & ]( float* data ) { singleReverb.apply( data, tileSize ); }, [ & ]( double* data ) { doubleReverb.apply( data, tileSize ); });
+
+    WaveShaper<float>  singleShaper( Parameters::Config::DISTORTION_AMT_DEF, 1.f );
+    WaveShaper<double> doubleShaper( Parameters::Config::DISTORTION_AMT_DEF, 1.f );
+    singleShaper.setSimdLevel( simdLevel );
+    doubleShaper.setSimdLevel( simdLevel );
+
+    report( "waveshaper", [ & ]( float* data ) { singleShaper.apply( data, tileSize ); }, [ & ]( double* data ) { doubleShaper.apply( data, tileSize ); });
+
+    float rate = Parameters::Config::LFO_MAX_RATE;
+
+    LFO<float>  singleLfo( _sampleRate );
+    LFO<double> doubleLfo( _sampleRate );
+    singleLfo.setRate( rate );
+    doubleLfo.setRate( rate );
+
+    report( "LFO", [ & ]( float* data ) { singleLfo.generate( data, tileSize ); }, [ & ]( double* data ) { doubleLfo.generate( data, tileSize ); });
+
+    // the phase of the LFO is accumulated tile by tile, the error is reported relative to the phase calculated
+    // at once for the elapsed time (in degrees, where a full cycle is 360 degrees)
+
+    singleLfo.setPhase( 0.f );
+    doubleLfo.setPhase( 0.0 );
+
+    juce::int64 elapsedSamples = 0;
+
+    for ( int minutes : { 1, 10, 60 }) {
+        auto sessionSamples = static_cast<juce::int64>( _sampleRate * 60.0 * minutes );
+
+        for ( ; elapsedSamples < sessionSamples; elapsedSamples += tileSize ) {
+            singleLfo.skip( tileSize );
+            doubleLfo.skip( tileSize );
+        }
+        double exactPhase = std::fmod( static_cast<double>( rate ) / _sampleRate * static_cast<double>( elapsedSamples ), 1.0 );
+
+        auto getError = [ exactPhase ]( double phase )
+        {
+            double error = std::abs( phase - exactPhase );
+            return std::min( error, 1.0 - error ) * 360.0;
+        };
+
+        juce::Logger::writeToLog( juce::String( "Delirion: LFO phase error after " ) + juce::String( minutes ) + " minutes: "
+                                  + juce::String( getError( singleLfo.getPhase()), 6 ) + " degrees in single precision, "
+                                  + juce::String( getError( doubleLfo.getPhase()), 6 ) + " degrees in double precision" );
+    }
+}
+#endif
+
 /* rendering */
 
 void AudioPluginAudioProcessor::processBlock( juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages )
 {
     juce::ignoreUnused( midiMessages );
+    renderBlock( buffer );
+}
+
+void AudioPluginAudioProcessor::processBlock( juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages )
+{
+    juce::ignoreUnused( midiMessages );
+    renderBlock( buffer );
+}
+
+template <typename SampleType>
+void AudioPluginAudioProcessor::renderBlock( juce::AudioBuffer<SampleType>& buffer )
+{
     juce::ScopedNoDenormals noDenormals;
+    REALTIME_SECTION();
+
+#if DELIRION_WATCHDOG
+    watchdog.start();
+#endif
   
-    int channelAmount = buffer.getNumChannels();
+    constexpr bool isDoublePrecision = std::is_same_v<SampleType, double>;
+
+    auto& strips       = forPrecision<SampleType>( channelStrips, doubleChannelStrips );
+    auto& bandBuffer   = forPrecision<SampleType>( bandBuffers, doubleBandBuffers );
+    auto& linkedOutput = forPrecision<SampleType>( linkedBuffer, doubleLinkedBuffer );
+
+    jassert( strips.size() > 0 || getTotalNumOutputChannels() == 0 ); // prepared for the precision being rendered
+
+    int channelAmount = std::min( buffer.getNumChannels(), strips.size());
     int bufferSize    = buffer.getNumSamples();
 
-    auto currentPosition = getPlayHead()->getPosition();
+    TRACE_DEADLINE( tracer, juce::Time::getHighResolutionTicks(), bufferSize, _sampleRate );
+    TRACE_BEGIN( tracer, "processBlock" );
+
+    auto* hostPlayHead = getPlayHead();
+    auto currentPosition = hostPlayHead != nullptr ? hostPlayHead->getPosition() : juce::Optional<juce::AudioPlayHead::PositionInfo>();
+
+    // determine which bands are rendered in this block (disabled bands are skipped entirely)
+
+    acquireBands();
+
+    bool renderDistortion = isBandRendered[ ChannelStrip::DISTORTION_BAND ];
+    bool renderReverb     = isBandRendered[ ChannelStrip::REVERB_BAND ];
+    int  numLanes         = 0; // amount of bands up to (and including) the highest rendered band
+
+    for ( int band = 0; band < ChannelStrip::MAX_BANDS; ++band ) {
+        if ( isBandRendered[ band ]) {
+            numLanes = band + 1;
+        }
+    }
 
     if ( currentPosition.hasValue() && alignWithSequencer( currentPosition )) {
-        for ( int channel = 0; channel < channelAmount; ++channel ) {
-            lowDopplerEffects[ channel ]->updateTempo( tempo, timeSigNumerator, timeSigDenominator );
-            midDopplerEffects[ channel ]->updateTempo( tempo, timeSigNumerator, timeSigDenominator );
-            hiDopplerEffects [ channel ]->updateTempo( tempo, timeSigNumerator, timeSigDenominator );
-        }    
+        TRACE_INSTANT( tracer, "record buffer reset" );
+
+        for ( int band = 0; band < ChannelStrip::MAX_BANDS; ++band ) {
+            if ( !isBandRendered[ band ]) {
+                continue;
+            }
+            for ( auto* strip : strips ) {
+                strip->dopplerEffects[ band ].updateTempo( tempo, timeSigNumerator, timeSigDenominator );
+            }
+        }
     }
 
     float dryMix = 1.f - *wetDryMix;
     float wetMix = *wetDryMix;
 
-    // Create temporary buffers for each band
-    juce::AudioBuffer<float> lowBuffer( channelAmount, bufferSize );
-    juce::AudioBuffer<float> midBuffer( channelAmount, bufferSize );
-    juce::AudioBuffer<float> hiBuffer ( channelAmount, bufferSize );
+    // when the mix is fully wet, the dry signal isn't needed after the band fan-out
+    // and the highest rendered band can be rendered in place within the output buffer
+    // (unless rendering in double precision, where the lanes are converted for the single precision modules)
+
+    bool isFullyWet = dryMix <= 0.f && !isDoublePrecision;
+    int inPlaceBand = isFullyWet ? numLanes - 1 : -1;
+
+    // when splitting the input, all bands up to the band count are split (so the highest rendered band
+    // doesn't contain the content of the bands above it), the filter states are cleared when switching modes
 
-    for ( int channel = 0; channel < channelAmount; ++channel )
+    int mode      = juce::roundToInt( crossoverMode->load());
+    int numSplits = std::max( numLanes, getNumBands());
+
+    int reverb     = juce::roundToInt( reverbType->load());
+    int distortion = juce::roundToInt( distortionType->load());
+
+    // when the effects aren't followed by the band filters, the waveshaper is applied within the band mix
+
+    bool fuseDistortion = FUSE_DISTORTION && renderDistortion && distortion == DISTORTION_WAVESHAPER && mode != CROSSOVER_POST_FILTER;
+
+    if ( reverb != activeReverbType ) {
+        convolutionReverb->reset(); // the Freeverb reverbs retain their state (as when their band was disabled)
+        fdnReverb->reset();
+        activeReverbType = reverb;
+    }
+    convolutionReverb->setNonRealtime( isNonRealtime()); // (when rendering offline, its tail is waited for)
+
+    if ( mode != activeCrossoverMode ) {
+        for ( auto* strip : strips ) {
+            strip->filterState.reset();
+            strip->crossoverState.reset();
+            strip->linearPhaseState.reset();
+        }
+        activeCrossoverMode = mode;
+    }
+
+    // channels of linked bands share the same LFO settings and can thus share the Doppler rate trajectory
+    // computed for the first channel. When their input is identical to the first channels input for at least
+    // the duration of the recorded history (e.g. mono sources), their Doppler output is copied instead.
+
+    bool isLinked[ ChannelStrip::MAX_BANDS ];
+
+    for ( int band = 0; band < ChannelStrip::MAX_BANDS; ++band ) {
+        isLinked[ band ] = isBandLinked[ band ].load();
+    }
+
+    // render the block in tiles so the band buffers (sized to a single tile) remain cache resident
+    // for the entire processing chain, regardless of the block size provided by the host
+
+    float fBufferSize = static_cast<float>( bufferSize );
+
+    for ( int tileStart = 0; tileStart < bufferSize; tileStart += maxTileSize )
     {
-        if ( buffer.getReadPointer( channel ) == nullptr ) {
-            continue;
+        int tileSize = std::min( maxTileSize, bufferSize - tileStart );
+
+        // bands that are being enabled or disabled fade in/out over the duration of the block
+
+        float tileStartGain[ ChannelStrip::MAX_BANDS ];
+        float tileEndGain  [ ChannelStrip::MAX_BANDS ];
+
+        for ( int band = 0; band < ChannelStrip::MAX_BANDS; ++band ) {
+            float gainRange = bandEndGain[ band ] - bandStartGain[ band ];
+
+            tileStartGain[ band ] = bandStartGain[ band ] + gainRange * ( static_cast<float>( tileStart ) / fBufferSize );
+            tileEndGain  [ band ] = bandStartGain[ band ] + gainRange * ( static_cast<float>( tileStart + tileSize ) / fBufferSize );
         }
 
-        lowBuffer.copyFrom ( channel, 0, buffer, channel, 0, bufferSize );
-        midBuffer.copyFrom ( channel, 0, buffer, channel, 0, bufferSize );
-        hiBuffer.copyFrom  ( channel, 0, buffer, channel, 0, bufferSize );
+        // compare the input of the subsequent channels against the first channels input
 
-        lowDopplerEffects[ channel ]->apply( lowBuffer, channel );
-        midDopplerEffects[ channel ]->apply( midBuffer, channel );
-        hiDopplerEffects [ channel ]->apply( hiBuffer,  channel );
+        bool isMirrored[ ChannelStrip::MAX_BANDS ] = {};
+        bool isLeaderRendered = false;
 
-        // apply the effects
+        for ( int channel = 1; channel < channelAmount; ++channel ) {
+            auto* strip    = strips[ channel ];
+            auto* input    = buffer.getReadPointer( channel, tileStart );
+            auto* leader   = buffer.getReadPointer( 0, tileStart );
 
-        // bitCrusher->apply( lowBuffer, channel );
-        waveShaper->apply( lowBuffer, channel );
+            if ( input != nullptr && leader != nullptr && std::memcmp( input, leader, sizeof( SampleType ) * static_cast<size_t>( tileSize )) == 0 ) {
+                strip->identicalInputSamples = std::min( strip->identicalInputSamples + tileSize, idleAfterSamples );
+            } else {
+                strip->identicalInputSamples = 0;
+            }
 
-        reverbs[ channel ]->apply( midBuffer, channel );
+            for ( int band = 0; band < ChannelStrip::MAX_BANDS; ++band ) {
+                isMirrored[ band ] = isMirrored[ band ] || ( isLinked[ band ] && strip->identicalInputSamples >= idleAfterSamples );
+            }
+        }
+
+        for ( int channel = 0; channel < channelAmount; ++channel )
+        {
+            if ( buffer.getReadPointer( channel ) == nullptr ) {
+                continue;
+            }
+
+            auto* channelData = buffer.getWritePointer( channel, tileStart );
+            auto* strip       = strips[ channel ];
+
+            // silence detection
+
+            auto inputRange = juce::FloatVectorOperations::findMinAndMax( channelData, tileSize );
+
+            if ( std::max( -inputRange.getStart(), inputRange.getEnd()) > Parameters::Config::SILENCE_THRESHOLD ) {
+                strip->silentSamples = 0;
+                strip->isIdle = false; // wake up as soon as input arrives
+            } else {
+                strip->silentSamples = std::min( strip->silentSamples + tileSize, idleAfterSamples );
+            }
+
+            if ( strip->isIdle ) {
+                strip->identicalInputSamples = 0;
+
+                for ( int band = 0; band < ChannelStrip::MAX_BANDS; ++band ) {
+                    if ( isBandRendered[ band ]) {
+                        strip->dopplerEffects[ band ].skip( tileSize );
+                    }
+                }
+                juce::FloatVectorOperations::multiply( channelData, static_cast<SampleType>( dryMix ), tileSize );
+                continue;
+            }
+            // fan out the input into the rendered bands (bands that aren't rendered have no data)
+            // or split the input into all bands (of which only the rendered bands are processed)
+
+            SampleType* bandData[ ChannelStrip::MAX_BANDS ] = {};
+
+            if ( mode == CROSSOVER_LINKWITZ_RILEY ) {
+                TRACE_BEGIN( tracer, "crossover", channel );
+
+                for ( int band = 0; band < numSplits; ++band ) {
+                    bandData[ band ] = band == inPlaceBand ? channelData : bandBuffer.getWritePointer( band );
+                }
+                renderSinglePrecision( channelData, bandData, numSplits, tileSize, [ & ]( float* input, float* const* bands ) {
+                    crossover.split( strip->crossoverState, input, bands, numSplits, tileSize );
+                });
+
+                TRACE_END( tracer, "crossover", channel );
+            } else if ( mode == CROSSOVER_LINEAR_PHASE ) {
+                // each band is filtered individually, only the rendered bands are split (the input
+                // within channelData is replaced by the input delayed by the crossovers latency)
+
+                TRACE_BEGIN( tracer, "crossover", channel );
+
+                for ( int band = 0; band < numLanes; ++band ) {
+                    if ( isBandRendered[ band ]) {
+                        bandData[ band ] = band == inPlaceBand ? channelData : bandBuffer.getWritePointer( band );
+                    }
+                }
+                renderSinglePrecision( channelData, bandData, numLanes, tileSize, [ & ]( float* input, float* const* bands ) {
+                    linearPhaseCrossover->split( strip->linearPhaseState, input, bands, numLanes, tileSize );
+                });
+
+                TRACE_END( tracer, "crossover", channel );
+            } else {
+                for ( int band = 0; band < numLanes; ++band ) {
+                    if ( !isBandRendered[ band ]) {
+                        continue;
+                    }
+                    if ( band == inPlaceBand ) {
+                        bandData[ band ] = channelData;
+                    } else {
+                        bandData[ band ] = bandBuffer.getWritePointer( band );
+                        juce::FloatVectorOperations::copy( bandData[ band ], channelData, tileSize );
+                    }
+                }
+            }
+
+            if ( channel == 0 ) {
+                isLeaderRendered = true;
+            } else if ( !isLeaderRendered ) {
+                strip->identicalInputSamples = 0; // first channel is idle and no longer records its history
+            }
+
+            TRACE_BEGIN( tracer, "doppler", channel );
+
+            for ( int band = 0; band < ChannelStrip::MAX_BANDS; ++band ) {
+                if ( !isBandRendered[ band ]) {
+                    continue;
+                }
+                auto& dopplerEffect = strip->dopplerEffects[ band ];
+                auto& leader        = strips[ 0 ]->dopplerEffects[ band ];
+
+                if ( channel == 0 || !isLinked[ band ] || !isLeaderRendered ) {
+                    dopplerEffect.apply( bandData[ band ], tileSize );
+
+                    if ( channel == 0 && isMirrored[ band ]) {
+                        juce::FloatVectorOperations::copy( linkedOutput.getWritePointer( band ), bandData[ band ], tileSize );
+                    }
+                } else if ( strip->identicalInputSamples >= idleAfterSamples ) {
+                    dopplerEffect.mirror( bandData[ band ], tileSize, leader, linkedOutput.getReadPointer( band ));
+                } else {
+                    dopplerEffect.apply( bandData[ band ], tileSize, leader );
+                }
+            }
+            TRACE_END( tracer, "doppler", channel );
+
+            // apply the effects
+
+            if ( renderDistortion && !fuseDistortion ) {
+                TRACE_BEGIN( tracer, "distortion", channel );
+                if ( distortion == DISTORTION_BITCRUSHER ) {
+                    renderSinglePrecision( bandData[ ChannelStrip::DISTORTION_BAND ], nullptr, 0, tileSize, [ & ]( float* band, float* const* ) {
+                        bitCrusher->apply( channel, band, tileSize );
+                    });
+                } else {
+                    forPrecision<SampleType>( waveShaper, doubleWaveShaper )->apply( bandData[ ChannelStrip::DISTORTION_BAND ], tileSize );
+                }
+                TRACE_END( tracer, "distortion", channel );
+            }
+
+            if ( renderReverb ) {
+                TRACE_BEGIN( tracer, "reverb", channel );
+                switch ( reverb ) {
+                    case REVERB_CONVOLUTION:
+                        renderSinglePrecision( bandData[ ChannelStrip::REVERB_BAND ], nullptr, 0, tileSize, [ & ]( float* band, float* const* ) {
+                            convolutionReverb->apply( channel, band, tileSize );
+                        });
+                        break;
+                    case REVERB_FDN:
+                        renderSinglePrecision( bandData[ ChannelStrip::REVERB_BAND ], nullptr, 0, tileSize, [ & ]( float* band, float* const* ) {
+                            fdnReverb->apply( channel, band, tileSize ); // rendered below
+                        });
+                        break;
+                    default:
+                        strip->reverb.apply( bandData[ ChannelStrip::REVERB_BAND ], tileSize );
+                        break;
+                }
+                TRACE_END( tracer, "reverb", channel );
+            }
+            
+            // apply the filtering (all bands at once, unless the bands were split before applying the effects)
+
+            if ( mode == CROSSOVER_POST_FILTER ) {
+                TRACE_BEGIN( tracer, "filter", channel );
+                renderSinglePrecision( nullptr, bandData, numLanes, tileSize, [ & ]( float*, float* const* lanes ) {
+                    filterBank.process( strip->filterState, lanes, numLanes, tileSize );
+                });
+                TRACE_END( tracer, "filter", channel );
+            }
+
+            // write the effected tile into the output
         
-        // apply the filtering
+            TRACE_BEGIN( tracer, "mix", channel );
+
+            TileMix<SampleType> mix { channelData, bandData, tileStartGain, tileEndGain, numLanes, inPlaceBand, fuseDistortion, dryMix, wetMix, tileSize };
+
+            if constexpr ( isDoublePrecision ) {
+                mixTile( mix );
+            } else {
+                ( this->*mixVariant )( mix );
+            }
+
+            // go idle once the histories have been filled with silence and the output has decayed
+            // (a frozen reverb keeps ringing and thus keeps the channel active)
+
+            bool isReverbActive = reverb == REVERB_CONVOLUTION ? convolutionReverb->isActive() :
+                                  reverb == REVERB_FDN ? fdnReverb->isActive() : strip->reverb.isActive();
+
+            if ( strip->silentSamples >= idleAfterSamples && !( renderReverb && isReverbActive )) {
+                auto outputRange = juce::FloatVectorOperations::findMinAndMax( channelData, tileSize );
+
+                if ( std::max( -outputRange.getStart(), outputRange.getEnd()) <= Parameters::Config::SILENCE_THRESHOLD ) {
+                    strip->isIdle = true;
+                    strip->filterState.reset();
+                    strip->crossoverState.reset();
+                    strip->linearPhaseState.reset();
+                }
+            }
+            TRACE_END( tracer, "mix", channel );
+        }
+
+        // the FDN is shared by all channels and thus rendered once all channels have been applied
+
+        if ( renderReverb && reverb == REVERB_FDN ) {
+            TRACE_BEGIN( tracer, "reverb" );
+            fdnReverb->advance( tileSize );
+            TRACE_END( tracer, "reverb" );
+        }
+    }
+
+    acknowledgeBands();
+
+#if DELIRION_TRACING
+    if ( channelAmount > 0 && strips[ 0 ]->reverb.getMode() != lastReverbMode ) {
+        lastReverbMode = strips[ 0 ]->reverb.getMode();
+        TRACE_INSTANT( tracer, "reverb freeze", "mode", lastReverbMode );
+    }
+#endif
+    TRACE_END( tracer, "processBlock", Tracer::MAIN_TRACK, "samples", bufferSize );
+
+#if DELIRION_WATCHDOG
+    double load = watchdog.stop( bufferSize, _sampleRate );
+
+    if ( load > 1.0 && !isNonRealtime()) {
+        logOverrun( load, bufferSize );
+    }
+#endif
+}
 
-        lowPassFilters [ channel ]->processSamples( lowBuffer.getWritePointer( channel ), bufferSize );
-        bandPassFilters[ channel ]->processSamples( midBuffer.getWritePointer( channel ), bufferSize );
-        highPassFilters[ channel ]->processSamples( hiBuffer.getWritePointer ( channel ), bufferSize );
+template <typename SampleType>
+void AudioPluginAudioProcessor::mixTile( const TileMix<SampleType>& mix )
+{
+    // (when rendered in place, the band already resides in the output and wet mix equals 1,
+    // it is ramped before the other bands are mixed into the output)
+
+    SampleType* output = mix.output;
+    int inPlaceBand = mix.inPlaceBand;
+    auto* shaper    = forPrecision<SampleType>( waveShaper, doubleWaveShaper );
+
+    if ( inPlaceBand < 0 ) {
+        juce::FloatVectorOperations::multiply( output, static_cast<SampleType>( mix.dryMix ), mix.size ); // clears the input when fully wet
+    } else if ( mix.fuseDistortion && inPlaceBand == ChannelStrip::DISTORTION_BAND ) {
+        rampBand( output, mix.size, mix.startGains[ inPlaceBand ], mix.endGains[ inPlaceBand ], shaper->getKernel());
+    } else {
+        rampBand( output, mix.size, mix.startGains[ inPlaceBand ], mix.endGains[ inPlaceBand ]);
+    }
+
+    for ( int band = 0; band < mix.numLanes; ++band ) {
+        if ( !isBandRendered[ band ] || band == inPlaceBand ) {
+            continue;
+        }
+        if ( mix.fuseDistortion && band == ChannelStrip::DISTORTION_BAND ) {
+            mixBand( mix.bands[ band ], output, mix.size, mix.wetMix, mix.startGains[ band ], mix.endGains[ band ], shaper->getKernel());
+        } else {
+            mixBand( mix.bands[ band ], output, mix.size, mix.wetMix, mix.startGains[ band ], mix.endGains[ band ]);
+        }
+    }
+}
+
+DELIRION_TARGET_BASELINE void AudioPluginAudioProcessor::mixTileBaseline( const TileMix<float>& mix )
+{
+    mixTile( mix );
+}
+
+DELIRION_TARGET_AVX2 void AudioPluginAudioProcessor::mixTileAvx2( const TileMix<float>& mix )
+{
+    mixTile( mix );
+}
+
+DELIRION_TARGET_AVX512 void AudioPluginAudioProcessor::mixTileAvx512( const TileMix<float>& mix )
+{
+    mixTile( mix );
+}
 
-        // write the effected buffer into the output
-    
+template <typename Function>
+void AudioPluginAudioProcessor::renderSinglePrecision( double* channelData, double* const* bands, int numBands, int bufferSize, const Function& render )
+{
+    // the channel data is converted into the last lane, each band into the lane of the same index
+
+    auto toSingle = [ bufferSize ]( const double* source, float* destination ) {
+        for ( int i = 0; i < bufferSize; ++i ) {
+            destination[ i ] = static_cast<float>( source[ i ]);
+        }
+    };
+    auto toDouble = [ bufferSize ]( const float* source, double* destination ) {
         for ( int i = 0; i < bufferSize; ++i ) {
-            auto input = buffer.getSample( channel, i ) * dryMix;
+            destination[ i ] = static_cast<double>( source[ i ]);
+        }
+    };
+
+    float* singleData = nullptr;
+    float* singleBands[ ChannelStrip::MAX_BANDS ] = {};
+
+    if ( channelData != nullptr ) {
+        singleData = singlePrecisionBuffer.getWritePointer( ChannelStrip::MAX_BANDS );
+        toSingle( channelData, singleData );
+    }
+    for ( int band = 0; band < numBands; ++band ) {
+        if ( bands[ band ] != nullptr ) {
+            singleBands[ band ] = singlePrecisionBuffer.getWritePointer( band );
+            toSingle( bands[ band ], singleBands[ band ]);
+        }
+    }
+
+    render( singleData, singleBands );
 
-            buffer.setSample(
-                channel, i,
-                input + (
-                    lowBuffer.getSample( channel, i ) +
-                    midBuffer.getSample( channel, i ) +
-                    hiBuffer.getSample ( channel, i )
-                ) * wetMix
-            );
+    if ( channelData != nullptr ) {
+        toDouble( singleData, channelData );
+    }
+    for ( int band = 0; band < numBands; ++band ) {
+        if ( bands[ band ] != nullptr ) {
+            toDouble( singleBands[ band ], bands[ band ]);
         }
     }
 }
 
+#if DELIRION_WATCHDOG
+void AudioPluginAudioProcessor::logOverrun( double load, int numSamples )
+{
+    float values[ Debug::MAX_VALUES ];
+    int numValues = static_cast<int>( overrunValueNames.size());
+
+    values[ 0 ] = static_cast<float>( load );
+    values[ 1 ] = static_cast<float>( numSamples );
+
+    for ( size_t i = 0; i < watchedParameters.size(); ++i ) {
+        values[ i + 2 ] = watchedParameters[ i ]->load();
+    }
+    logger.log( "deadline overrun", values, overrunValueNames.data(), numValues );
+}
+#endif
+
 /* editor */
 
 bool AudioPluginAudioProcessor::hasEditor() const
@@ -336,8 +1451,61 @@ void AudioPluginAudioProcessor::setStateInformation( const void* data, int sizeI
 {
     juce::ValueTree tree = juce::ValueTree::readFromData( data, static_cast<unsigned long>( sizeInBytes ));
     if ( tree.isValid()) {
+        auto previousFile = getImpulseResponseFile();
+
         parameters.state = tree;
+
+        // (when not prepared, the impulse response is loaded in prepareToPlay())
+
+        if ( convolutionReverb != nullptr && getImpulseResponseFile() != previousFile ) {
+            // the impulse response is prepared while rendering, only swapping it requires processing to be suspended
+
+            auto impulseResponse = createImpulseResponse();
+
+            suspendProcessing( true );
+            convolutionReverb->setImpulseResponse( std::move( impulseResponse ));
+            suspendProcessing( false );
+        }
+    }
+}
+
+bool AudioPluginAudioProcessor::loadImpulseResponse( const juce::File& file )
+{
+    if ( convolutionReverb != nullptr ) {
+        // the impulse response is prepared while rendering, only swapping it requires processing to be suspended
+
+        auto impulseResponse = file.existsAsFile() ? convolutionReverb->createImpulseResponse( file )
+                                                   : convolutionReverb->createDefaultImpulseResponse( Parameters::Config::REVERB_DECAY_DEF );
+        if ( impulseResponse == nullptr ) {
+            return false;
+        }
+        suspendProcessing( true );
+        convolutionReverb->setImpulseResponse( std::move( impulseResponse ));
+        suspendProcessing( false );
+    }
+    // (when not prepared, the impulse response is loaded in prepareToPlay())
+
+    parameters.state.setProperty( Parameters::IMPULSE_RESPONSE, file.getFullPathName(), nullptr );
+    return true;
+}
+
+juce::File AudioPluginAudioProcessor::getImpulseResponseFile() const
+{
+    auto path = parameters.state.getProperty( Parameters::IMPULSE_RESPONSE ).toString();
+    return juce::File::isAbsolutePath( path ) ? juce::File( path ) : juce::File();
+}
+
+std::unique_ptr<ConvolutionReverb::ImpulseResponse> AudioPluginAudioProcessor::createImpulseResponse()
+{
+    auto file = getImpulseResponseFile();
+
+    if ( file.existsAsFile()) {
+        if ( auto impulseResponse = convolutionReverb->createImpulseResponse( file )) {
+            return impulseResponse;
+        }
+        DBG( "Delirion: could not read impulse response " << file.getFullPathName() << ", using the default impulse response" );
     }
+    return convolutionReverb->createDefaultImpulseResponse( Parameters::Config::REVERB_DECAY_DEF );
 }
 
 /* runtime state */
@@ -349,12 +1517,16 @@ bool AudioPluginAudioProcessor::alignWithSequencer( juce::Optional<juce::AudioPl
 
     if ( !wasPlaying && isPlaying ) {
         // sequencer started playback
-        int channelAmount = getTotalNumOutputChannels();
-
-        for ( int channel = 0; channel < channelAmount; ++channel ) {
-            lowDopplerEffects[ channel ]->onSequencerStart();
-            midDopplerEffects[ channel ]->onSequencerStart();
-            hiDopplerEffects [ channel ]->onSequencerStart();
+        TRACE_INSTANT( tracer, "sequencer start" );
+        TRACE_INSTANT( tracer, "record buffer reset" );
+
+        for ( int band = 0; band < ChannelStrip::MAX_BANDS; ++band ) {
+            if ( !isBandRendered[ band ]) {
+                continue;
+            }
+            forEachStrip( [ & ]( auto* strip ) {
+                strip->dopplerEffects[ band ].onSequencerStart();
+            });
         }
     }
 
@@ -366,6 +1538,8 @@ bool AudioPluginAudioProcessor::alignWithSequencer( juce::Optional<juce::AudioPl
     if ( curTempo.hasValue() && !juce::approximatelyEqual( tempo, *curTempo )) {
         tempo = *curTempo;
         hasChange = true;
+
+        TRACE_INSTANT( tracer, "tempo change", "bpm", tempo );
     }
 
     if ( timeSig.hasValue() && ( timeSigNumerator != timeSig->numerator || timeSigDenominator != timeSig->denominator )) {
@@ -17,15 +17,25 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
-// #include "modules/bitcrusher/Bitcrusher.h"
-#include "modules/doppler/DopplerEffect.h"
-#include "modules/reverb/Reverb.h"
+#include "modules/bitcrusher/Bitcrusher.h"
 #include "modules/waveshaper/WaveShaper.h"
+#include "modules/chain/Chain.h"
+#include "utils/Debug.h"
+#include "utils/MemorySlab.h"
+#include "utils/RealtimeGuard.h"
+#include "utils/Tracer.h"
+#include "utils/Watchdog.h"
+#include "modules/filter/Crossover.h"
+#include "modules/filter/FilterBank.h"
+#include "modules/filter/LinearPhaseCrossover.h"
+#include "modules/reverb/ConvolutionReverb.h"
+#include "modules/reverb/FdnReverb.h"
+#include "ChannelStrip.h"
 #include "Parameters.h"
 #include "ParameterListener.h"
 #include "ParameterSubscriber.h"
 
-class AudioPluginAudioProcessor final : public juce::AudioProcessor, ParameterSubscriber
+class AudioPluginAudioProcessor final : public juce::AudioProcessor, ParameterSubscriber, private juce::Timer
 {
     public:
         AudioPluginAudioProcessor();
@@ -40,6 +50,7 @@ class AudioPluginAudioProcessor final : public juce::AudioProcessor, ParameterSu
         bool producesMidi() const override;
         bool isMidiEffect() const override;
         double getTailLengthSeconds() const override;
+        bool supportsDoublePrecisionProcessing() const override;
 
         /* programs */
 
@@ -54,10 +65,26 @@ class AudioPluginAudioProcessor final : public juce::AudioProcessor, ParameterSu
         void prepareToPlay( double sampleRate, int samplesPerBlock ) override;
         void releaseResources() override;
 
+        // the amount of bytes reserved for the delay memory of this instance (and the
+        // amount thereof that is currently committed, e.g. held by the enabled bands)
+
+        size_t getDelayMemorySize() const;
+        size_t getCommittedDelayMemorySize() const;
+
+        // limits the instruction set used by the kernels (see Simd) from the next call to prepareToPlay(). The
+        // wider levels fuse multiplications and additions, so only LEVEL_BASELINE renders alike on all CPUs
+
+        void setMaxSimdLevel( int level );
+
+        // renders the host provided blocks in tiles of at most given size, limited to Parameters::Config::TILE_SIZE
+        // (which the effects are sized for). Allows measuring the throughput of smaller tiles, not to be called while rendering
+
+        void setMaxTileSize( int size );
+
         /* rendering */
 
         void processBlock( juce::AudioBuffer<float>&, juce::MidiBuffer& ) override;
-        using AudioProcessor::processBlock;
+        void processBlock( juce::AudioBuffer<double>&, juce::MidiBuffer& ) override;
 
         /* automatable parameters */
 
@@ -80,6 +107,10 @@ class AudioPluginAudioProcessor final : public juce::AudioProcessor, ParameterSu
             params.push_back( std::make_unique<juce::AudioParameterBool> ( Parameters::HI_LFO_LINK,  "Hi LFO link",  true )); 
             
             params.push_back( std::make_unique<juce::AudioParameterFloat>( Parameters::DISTORTION_MIX, "Low drive", 0.f, 1.f, Parameters::Config::DISTORTION_WET_DEF ));
+            params.push_back( std::make_unique<juce::AudioParameterChoice>( Parameters::DISTORTION_TYPE, "Low distortion",
+                juce::StringArray { "Waveshaper", "Bitcrusher" }, DISTORTION_WAVESHAPER
+            ));
+            params.push_back( std::make_unique<juce::AudioParameterFloat>( Parameters::DISTORTION_RATE, "Low downsampling", 0.f, 1.f, Parameters::Config::DISTORTION_RATE_DEF ));
             
             params.push_back( std::make_unique<juce::AudioParameterFloat>( Parameters::LOW_BAND, "Low band",
                 Parameters::Ranges::LOW_BAND_MIN, Parameters::Ranges::LOW_BAND_MAX, Parameters::Config::LOW_BAND_DEF
@@ -91,13 +122,33 @@ class AudioPluginAudioProcessor final : public juce::AudioProcessor, ParameterSu
                 Parameters::Ranges::HI_BAND_MIN, Parameters::Ranges::HI_BAND_MAX, Parameters::Config::HI_BAND_DEF
             ));
 
+            params.push_back( std::make_unique<juce::AudioParameterInt>( Parameters::BAND_COUNT, "Band count",
+                Parameters::Config::MIN_BANDS, Parameters::Config::MAX_BANDS, Parameters::Config::BAND_COUNT_DEF
+            ));
+            params.push_back( std::make_unique<juce::AudioParameterChoice>( Parameters::CROSSOVER_MODE, "Crossover",
+                juce::StringArray { "Post filter", "Linkwitz-Riley", "Linear phase" }, CROSSOVER_POST_FILTER
+            ));
+
+            params.push_back( std::make_unique<juce::AudioParameterBool>( Parameters::LOW_BAND_ENABLED, "Low band enabled",  true ));
+            params.push_back( std::make_unique<juce::AudioParameterBool>( Parameters::MID_BAND_ENABLED, "Mid band enabled",  true ));
+            params.push_back( std::make_unique<juce::AudioParameterBool>( Parameters::HI_BAND_ENABLED,  "High band enabled", true ));
+            params.push_back( std::make_unique<juce::AudioParameterBool>( Parameters::LOW_BAND_SOLO,    "Low band solo",  false ));
+            params.push_back( std::make_unique<juce::AudioParameterBool>( Parameters::MID_BAND_SOLO,    "Mid band solo",  false ));
+            params.push_back( std::make_unique<juce::AudioParameterBool>( Parameters::HI_BAND_SOLO,     "High band solo", false ));
+
             params.push_back( std::make_unique<juce::AudioParameterFloat>( Parameters::WET_DRY_MIX, "Wet / dry mix",
                 0.f, 1.f, Parameters::Config::WET_DRY_MIX_DEF
             ));
 
             params.push_back( std::make_unique<juce::AudioParameterBool>( Parameters::REVERB_FREEZE, "Freeze", false ));    
+            params.push_back( std::make_unique<juce::AudioParameterChoice>( Parameters::REVERB_TYPE, "Reverb type",
+                juce::StringArray { "Freeverb", "Convolution", "FDN" }, REVERB_FREEVERB
+            ));
             params.push_back( std::make_unique<juce::AudioParameterBool>( Parameters::INVERT_DIRECTION, "Invert", Parameters::Config::INVERT_DIR_DEF ));   
             params.push_back( std::make_unique<juce::AudioParameterBool>( Parameters::BEAT_SYNC, "Beat sync", true ));
+            params.push_back( std::make_unique<juce::AudioParameterChoice>( Parameters::LFO_WAVEFORM, "LFO waveform",
+                juce::StringArray { "Sine", "Triangle", "Random" }, LFO<float>::WAVEFORM_SINE
+            ));
 
             return { params.begin(), params.end() };
         }
@@ -111,22 +162,269 @@ class AudioPluginAudioProcessor final : public juce::AudioProcessor, ParameterSu
 
         void getStateInformation( juce::MemoryBlock& destData ) override;
         void setStateInformation( const void* data, int sizeInBytes ) override;
+
+        // loads the impulse response of the convolution reverb from given audio file (when not existing, the default
+        // impulse response is used). Returns false when the file could not be read. To be called from the message thread
+
+        bool loadImpulseResponse( const juce::File& file );
+        juce::File getImpulseResponseFile() const;
         
         /* runtime state */
 
         bool alignWithSequencer( juce::Optional<juce::AudioPlayHead::PositionInfo> positionInfo );
         
     private:
-        juce::OwnedArray<juce::IIRFilter> lowPassFilters;
-        juce::OwnedArray<juce::IIRFilter> bandPassFilters;
-        juce::OwnedArray<juce::IIRFilter> highPassFilters;
-
-        // BitCrusher* bitCrusher = nullptr;
-        WaveShaper* waveShaper = nullptr;
-        juce::OwnedArray<DopplerEffect> lowDopplerEffects;
-        juce::OwnedArray<DopplerEffect> midDopplerEffects;
-        juce::OwnedArray<DopplerEffect> hiDopplerEffects;
-        juce::OwnedArray<Reverb> reverbs;
+        // the lowest band is distorted by either the waveshaper or the bitcrusher
+
+        enum DistortionType { DISTORTION_WAVESHAPER = 0, DISTORTION_BITCRUSHER };
+
+        BitCrusher* bitCrusher = nullptr;
+        WaveShaper<float>* waveShaper = nullptr;
+        WaveShaper<double>* doubleWaveShaper = nullptr;
+
+        // the channel strips for the precision requested by the host (only the strips of that precision are created in
+        // prepareToPlay(), the effects of which render in the same precision while the filters remain single precision)
+
+        juce::OwnedArray<ChannelEffects<float>> channelStrips;
+        juce::OwnedArray<ChannelEffects<double>> doubleChannelStrips;
+
+        // selects the member used when rendering in given precision (e.g. doubleChannelStrips for double)
+
+        template <typename SampleType, typename Single, typename Double>
+        static inline auto& forPrecision( Single& single, Double& precise )
+        {
+            if constexpr ( std::is_same_v<SampleType, double> ) {
+                return precise;
+            } else {
+                return single;
+            }
+        }
+
+        // invokes given function for each strip (of the precision in use)
+
+        template <typename Function>
+        inline void forEachStrip( const Function& function )
+        {
+            for ( auto* strip : channelStrips ) {
+                function( strip );
+            }
+            for ( auto* strip : doubleChannelStrips ) {
+                function( strip );
+            }
+        }
+
+        // the delay memory of all channel strips is reserved as a single slab, divided into page aligned
+        // regions per strip and band so the memory of each band can be committed and decommitted individually
+
+        MemorySlab delayMemory;
+
+        // the band filters of all channels, processing all bands of a channel in parallel
+
+        FilterBank filterBank;
+
+        // the bands are either created by filtering a full band copy of the input after applying the effects
+        // (CROSSOVER_POST_FILTER) or by splitting the input before applying the effects (CROSSOVER_LINKWITZ_RILEY),
+        // in which case the effects only process their band limited signal and the bands sum flat. The latter
+        // can also be split without phase shift (CROSSOVER_LINEAR_PHASE) at the expense of added latency
+
+        enum CrossoverMode { CROSSOVER_POST_FILTER = 0, CROSSOVER_LINKWITZ_RILEY, CROSSOVER_LINEAR_PHASE };
+
+        Crossover crossover;
+        std::unique_ptr<LinearPhaseCrossover> linearPhaseCrossover; // created in prepareToPlay() (sized to the sample rate)
+        int activeCrossoverMode = CROSSOVER_POST_FILTER; // mode of the previous block, managed by the audio thread
+
+        // the reverb band is either processed by the Freeverb reverb of each strip or by a reverb shared
+        // by all strips: a convolution reverb or a feedback delay network (FDN)
+
+        enum ReverbType { REVERB_FREEVERB = 0, REVERB_CONVOLUTION, REVERB_FDN };
+
+        std::unique_ptr<ConvolutionReverb> convolutionReverb; // created in prepareToPlay() (sized to the sample rate)
+        std::unique_ptr<FdnReverb> fdnReverb;                 // idem
+        int activeReverbType = REVERB_FREEVERB; // type of the previous block, managed by the audio thread
+
+        std::unique_ptr<ConvolutionReverb::ImpulseResponse> createImpulseResponse();
+
+        /* band layout */
+
+        // the lowest band is controlled by the low band parameters, the highest band by the high band parameters
+        // and all bands in between by the mid band parameters. The frequencies and LFO speeds of the bands in
+        // between are interpolated by their position within the spectrum (0 = lowest band, 1 = highest band)
+        // so the band halfway (when using three bands: the mid band) uses the mid band settings
+
+        enum BandRole { ROLE_LOW = 0, ROLE_MID, ROLE_HI };
+
+        int getNumBands();
+
+        inline BandRole getBandRole( int band, int numBands )
+        {
+            return band == 0 ? ROLE_LOW : ( band == numBands - 1 ? ROLE_HI : ROLE_MID );
+        }
+
+        inline float getBandPosition( int band, int numBands )
+        {
+            return static_cast<float>( band ) / static_cast<float>( numBands - 1 );
+        }
+
+        // interpolates between the low, mid and high values for given position (exact at 0, 0.5 and 1)
+
+        inline float interpolateBandValue( float position, float low, float mid, float hi, bool logarithmic )
+        {
+            float from = position <= 0.5f ? low : mid;
+            float to   = position <= 0.5f ? mid : hi;
+            float fraction = position <= 0.5f ? position * 2.f : ( position - 0.5f ) * 2.f;
+
+            if ( logarithmic ) {
+                return std::pow( from, 1.f - fraction ) * std::pow( to, fraction );
+            }
+            return from * ( 1.f - fraction ) + to * fraction;
+        }
+
+        /* band activation */
+
+        // the delay memory of a band is only committed while the band is enabled. The message thread commits
+        // the memory before handing the band to the audio thread (ENABLING). When disabled (DISABLING), the
+        // audio thread fades the band out over one block and acknowledges it has stopped rendering (RELEASABLE),
+        // after which the message thread decommits the memory (DISABLED). Newly enabled bands fade in over one block.
+        // While enabled, the committed recording memory follows the size required by the current effect settings.
+
+        enum BandState { BAND_DISABLED = 0, BAND_ENABLING, BAND_ENABLED, BAND_DISABLING, BAND_RELEASABLE };
+        static const int MEMORY_UPDATE_INTERVAL_MS = 50;
+
+        std::atomic<int> bandStates[ ChannelStrip::MAX_BANDS ];
+        juce::CriticalSection bandAllocationLock; // serializes allocation across non-audio threads, never acquired on the audio thread
+
+        // state of the current block, managed by the audio thread
+
+        bool isBandRendered[ ChannelStrip::MAX_BANDS ] = {};
+        float bandStartGain[ ChannelStrip::MAX_BANDS ] = {};
+        float bandEndGain  [ ChannelStrip::MAX_BANDS ] = {};
+
+        // whether the channels of a band share the same LFO settings (managed by updateParameters())
+
+        std::atomic<bool> isBandLinked[ ChannelStrip::MAX_BANDS ];
+
+        bool isBandEnabled( int band );
+        void updateBandStates();
+        bool allocateBand( int band );
+        void releaseBand( int band );
+        void resizeRecordings();
+        void acquireBands();
+        void acknowledgeBands();
+        void timerCallback() override;
+
+        // once its effects have been applied, a band is ramped (when its gain changes) and mixed into the output
+        // in a single pass, optionally preceded by given stages (see Chain). The waveshaper is fused this way
+        // when no filtering follows the effects, unless tracing (so the distortion is still traced individually)
+
+        static constexpr bool FUSE_DISTORTION = DELIRION_TRACING == 0;
+
+        template <typename SampleType, typename... Stages>
+        inline void mixBand( const SampleType* bandData, SampleType* output, int bufferSize, float wetMix, float startGain, float endGain, Stages... stages )
+        {
+            if ( startGain != 1.f || endGain != 1.f ) {
+                Chain<Stages..., GainRamp, MixInto<SampleType>>( stages..., GainRamp( startGain, endGain, bufferSize ), MixInto<SampleType> { output, wetMix }).render( bandData, bufferSize );
+            } else {
+                Chain<Stages..., MixInto<SampleType>>( stages..., MixInto<SampleType> { output, wetMix }).render( bandData, bufferSize );
+            }
+        }
+
+        // as mixBand() for a band rendered in place within the output
+
+        template <typename SampleType, typename... Stages>
+        inline void rampBand( SampleType* output, int bufferSize, float startGain, float endGain, Stages... stages )
+        {
+            if ( startGain != 1.f || endGain != 1.f ) {
+                Chain<Stages..., GainRamp>( stages..., GainRamp( startGain, endGain, bufferSize )).apply( output, bufferSize );
+            } else if constexpr ( sizeof...( Stages ) > 0 ) {
+                Chain<Stages...>( stages... ).apply( output, bufferSize );
+            }
+        }
+
+        // mixes the bands of a tile into the output (see mixBand()), in a variant per instruction set (see Simd)
+        // for single precision (double precision is mixed using mixTile() directly)
+
+        template <typename SampleType>
+        struct TileMix
+        {
+            SampleType* output;
+            SampleType* const* bands;
+            const float* startGains;
+            const float* endGains;
+            int numLanes;
+            int inPlaceBand;
+            bool fuseDistortion;
+            float dryMix;
+            float wetMix;
+            int size;
+        };
+
+        using MixVariant = void ( AudioPluginAudioProcessor::* )( const TileMix<float>& );
+        MixVariant mixVariant = &AudioPluginAudioProcessor::mixTileBaseline;
+
+        template <typename SampleType>
+        void mixTile( const TileMix<SampleType>& mix );
+        void mixTileBaseline( const TileMix<float>& mix );
+        void mixTileAvx2    ( const TileMix<float>& mix );
+        void mixTileAvx512  ( const TileMix<float>& mix );
+
+        // renders a block in the precision of given buffer (see processBlock())
+
+        template <typename SampleType>
+        void renderBlock( juce::AudioBuffer<SampleType>& buffer );
+
+        // invokes given function for the modules rendering in single precision only (e.g. the filters, the shared
+        // reverbs and the bitcrusher), providing the channel data and band lanes to render. When rendering in double
+        // precision, these are converted to and from single precision scratch lanes (see singlePrecisionBuffer)
+
+        template <typename Function>
+        inline void renderSinglePrecision( float* channelData, float* const* bands, int numBands, int bufferSize, const Function& render )
+        {
+            juce::ignoreUnused( numBands, bufferSize );
+            render( channelData, bands );
+        }
+
+        template <typename Function>
+        void renderSinglePrecision( double* channelData, double* const* bands, int numBands, int bufferSize, const Function& render );
+
+        // the instruction set used by all kernels (see Simd), determined in prepareToPlay()
+
+        int simdLevel    = Simd::LEVEL_BASELINE;
+        int maxSimdLevel = Simd::NUM_LEVELS - 1;
+        void applySimdLevel( int level );
+
+        int maxTileSize = Parameters::Config::TILE_SIZE; // see setMaxTileSize()
+
+#if DELIRION_SIMD_REPORT
+        // logs the duration of each kernel for all levels supported by the CPU
+        void reportSimdLevels();
+#endif
+
+#if DELIRION_PRECISION_REPORT
+        // logs the duration of the effects in single and double precision and the phase drift of the LFO over a long session
+        void reportPrecision();
+#endif
+
+        // temporary buffers for each band, sized to a single processing tile and shared by all
+        // channels as these are rendered in succession (allocated in prepareToPlay() so rendering doesn't allocate)
+
+        juce::AudioBuffer<float> bandBuffers;
+        juce::AudioBuffer<double> doubleBandBuffers;
+
+        // Doppler output of the first channel for each band, mirrored by linked channels receiving identical input
+
+        juce::AudioBuffer<float> linkedBuffer;
+        juce::AudioBuffer<double> doubleLinkedBuffer;
+
+        // when rendering in double precision: the single precision lanes of each band and the channel data
+        // (the last lane) for the modules rendering in single precision only (see renderSinglePrecision())
+
+        juce::AudioBuffer<float> singlePrecisionBuffer;
+
+        // silence detection, channels whose input has been silent for longer than
+        // the effects tail (and whose output has decayed) are idle and skip processing
+
+        int idleAfterSamples = 0;
+        double tailLengthSeconds = 0.0;
         
         double _sampleRate;
         
@@ -134,6 +432,20 @@ class AudioPluginAudioProcessor final : public juce::AudioProcessor, ParameterSu
         int timeSigNumerator   = 4;
         int timeSigDenominator = 4;
         double tempo = 120.0;
+
+#if DELIRION_TRACING
+        std::unique_ptr<Tracer> tracer;
+        int lastReverbMode = 0;
+#endif
+
+#if DELIRION_WATCHDOG
+        Debug logger { "delirion_log.txt" };
+        Watchdog watchdog;
+        std::vector<const char*> overrunValueNames;
+        std::vector<std::atomic<float>*> watchedParameters;
+
+        void logOverrun( double load, int numSamples );
+#endif
         
         // parameters
 
@@ -147,13 +459,25 @@ class AudioPluginAudioProcessor final : public juce::AudioProcessor, ParameterSu
         std::atomic<float>* hiLfoEven;
         std::atomic<float>* hiLfoLink;
         std::atomic<float>* distortionMix;
+        std::atomic<float>* distortionType;
+        std::atomic<float>* distortionRate;
         std::atomic<float>* lowBand;
         std::atomic<float>* midBand;
         std::atomic<float>* hiBand;
+        std::atomic<float>* bandCount;
+        std::atomic<float>* crossoverMode;
+        std::atomic<float>* lowBandEnabled;
+        std::atomic<float>* midBandEnabled;
+        std::atomic<float>* hiBandEnabled;
+        std::atomic<float>* lowBandSolo;
+        std::atomic<float>* midBandSolo;
+        std::atomic<float>* hiBandSolo;
         std::atomic<float>* wetDryMix;
         std::atomic<float>* reverbFreeze;
+        std::atomic<float>* reverbType;
         std::atomic<float>* invertDirection;
         std::atomic<float>* beatSync;
+        std::atomic<float>* lfoWaveform;
         
         //==============================================================================
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR( AudioPluginAudioProcessor )
@@ -15,15 +15,17 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "Bitcrusher.h"
-#include <math.h>
+#include <cmath>
 
 /* constructor */
 
-BitCrusher::BitCrusher( float amount, float inputMix, float outputMix )
+BitCrusher::BitCrusher( float amount, float inputMix, float outputMix, int amountOfChannels )
 {
     setAmount   ( amount );
     setInputMix ( inputMix );
     setOutputMix( outputMix );
+
+    holdStates.resize( static_cast<size_t>( std::max( 1, amountOfChannels )));
 }
 
 BitCrusher::~BitCrusher()
@@ -33,24 +35,16 @@ BitCrusher::~BitCrusher()
 
 /* public methods */
 
-void BitCrusher::apply( juce::AudioBuffer<float>& buffer, int channel )
+void BitCrusher::apply( int channel, float* channelData, int bufferSize )
 {
     if ( !isActive() ) {
         return;
     }
 
-    auto* channelData = buffer.getWritePointer( channel );
-    int bufferSize    = buffer.getNumSamples();
-    
-    int bitsPlusOne = _bits + 1;
-
-    for ( int i = 0; i < bufferSize; ++i )
-    {
-        short input = ( short ) (( channelData[ i ] * _inputMix ) * SHRT_MAX );
-        short prevent_offset = ( short )( -1 >> bitsPlusOne );
-        input &= ( -1 << ( 16 - _bits ));
-        channelData[ i ] = (( input + prevent_offset ) * _outputMix ) / SHRT_MAX;
+    if ( _rate < 1.f ) {
+        hold( holdStates[ static_cast<size_t>( channel ) % holdStates.size() ], channelData, bufferSize );
     }
+    quantise( channelData, bufferSize );
 }
 
 /* setters */
@@ -58,7 +52,7 @@ void BitCrusher::apply( juce::AudioBuffer<float>& buffer, int channel )
 void BitCrusher::setAmount( float value )
 {
     // note we invert the value as a higher value implies less bit rate reduction
-    _amount = abs( value - 1.f );
+    _amount = std::abs( value - 1.f );
 
     calcBits();
 }
@@ -73,10 +67,61 @@ void BitCrusher::setOutputMix( float value )
     _outputMix = juce::jlimit( 0.f, 1.f, value );
 }
 
+void BitCrusher::setDownsampling( float value )
+{
+    _rate = 1.f - juce::jlimit( 0.f, 1.f, value ) * ( 1.f - MIN_RATE );
+    _increment = static_cast<uint32_t>( std::min( 4294967295.0, static_cast<double>( _rate ) * 4294967296.0 ));
+}
+
 /* private methods */
 
 void BitCrusher::calcBits()
 {
     // scale float to 1 - 16 bit range
     _bits = ( int ) juce::jmap( _amount, 0.f, 1.f, 1.f, 16.f );
+
+    // clearing the lower bits floors each sample onto a grid of the given bit depth, adding
+    // half a step centers the grid around zero (the mask is derived from the step size rather
+    // than by shifting a negative value)
+
+    int step = 1 << ( 16 - _bits );
+
+    _mask   = -step;
+    _offset = step / 2;
+}
+
+void BitCrusher::quantise( float* channelData, int bufferSize )
+{
+    const int mask   = _mask;
+    const int offset = _offset;
+    const float inputScale  = _inputMix * 32767.f;
+    const float outputScale = _outputMix / 32767.f;
+
+    // the input is clamped to the 16-bit range before conversion (so the conversion can't overflow)
+
+    for ( int i = 0; i < bufferSize; ++i ) {
+        float input = std::min( 32767.f, std::max( -32768.f, channelData[ i ] * inputScale ));
+        int sample  = ( static_cast<int>( input ) & mask ) + offset;
+
+        channelData[ i ] = static_cast<float>( sample ) * outputScale;
+    }
+}
+
+void BitCrusher::hold( HoldState& state, float* channelData, int bufferSize )
+{
+    // the phase is a 32-bit fixed point fraction, a sample is taken each time it wraps
+    // (an integer addition keeps the loop carried dependency short)
+
+    const uint32_t increment = _increment;
+
+    uint32_t phase = state.phase;
+    float sample   = state.sample;
+
+    for ( int i = 0; i < bufferSize; ++i ) {
+        phase += increment;
+        sample = phase < increment ? channelData[ i ] : sample;
+        channelData[ i ] = sample;
+    }
+    state.phase  = phase;
+    state.sample = sample;
 }
@@ -17,28 +17,52 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
+#include <cstdint>
+#include <vector>
 
+/**
+ * Reduces the bit depth of the signal by quantising it in the 16-bit integer domain, optionally reducing
+ * its sample rate by holding each sample for a number of samples. Both passes are branchless loops chosen
+ * once per call, so the quantiser vectorizes and neither pass checks the settings per sample.
+ */
 class BitCrusher {
 
     public:
-        BitCrusher( float amount, float inputMix, float outputMix );
+        static constexpr float MIN_RATE = 1.f / 32.f; // of the sample rate, at full sample rate reduction
+
+        BitCrusher( float amount, float inputMix, float outputMix, int amountOfChannels );
         ~BitCrusher();
 
-        void apply( juce::AudioBuffer<float>& buffer, int channel );
+        void apply( int channel, float* channelData, int bufferSize );
 
         void setAmount( float value ); // range between -1 to +1
         void setInputMix( float value );
         void setOutputMix( float value );
+        void setDownsampling( float value ); // range between 0 (no sample rate reduction) and 1 (MIN_RATE)
 
         inline bool isActive() {
-            return _bits < 16;
+            return _bits < 16 || _rate < 1.f;
         }
 
     private:
         int _bits; // we scale the amount to integers in the 1-16 range
+        int _mask;
+        int _offset;
         float _amount;
         float _inputMix;
         float _outputMix;
+        float _rate = 1.f; // the rate at which a new sample is taken, relative to the sample rate
+        uint32_t _increment = 0xFFFFFFFF; // the rate as a fixed point phase increment
+
+        // the sample rate reduction state of each channel
+
+        struct HoldState {
+            uint32_t phase = 0xFFFFFFFF; // (a sample is taken on the first increment)
+            float sample   = 0.f;
+        };
+        std::vector<HoldState> holdStates;
 
         void calcBits();
+        void quantise( float* channelData, int bufferSize );
+        void hold( HoldState& state, float* channelData, int bufferSize );
 };
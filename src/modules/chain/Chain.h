@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <tuple>
+#include <utility>
+
+/**
+ * A chain of processing stages fused into a single pass over a block. Each stage exposes a per-sample kernel
+ * ( SampleType process( SampleType sample, int index )) which is inlined into a single loop, so each sample passes through
+ * all stages while residing in a register, rather than each stage reading and writing the entire block in turn.
+ * When none of the stages carries state from one sample to the next, the compiler vectorizes the fused loop
+ * (the per-sample kernels then effectively operate on a vector of samples at a time).
+ *
+ * The stages are part of the type (e.g. Chain<WaveShaper<float>::Kernel, GainRamp, MixInto<float>>), so chains are declared
+ * through type aliases which can differ per build configuration. Stages are small value types, created per block.
+ */
+template <typename... Stages>
+class Chain
+{
+    public:
+        explicit Chain( Stages... stagesToApply ) : stages( stagesToApply... ) {}
+
+        // processes given block in place
+
+        template <typename SampleType>
+        inline void apply( SampleType* channelData, int bufferSize )
+        {
+            auto local = stages; // (see render())
+
+            for ( int i = 0; i < bufferSize; ++i ) {
+                channelData[ i ] = process( local, channelData[ i ], i, std::index_sequence_for<Stages...>());
+            }
+        }
+
+        // processes given block without writing back its result (e.g. when the last stage writes into another buffer)
+
+        template <typename SampleType>
+        inline void render( const SampleType* channelData, int bufferSize )
+        {
+            // the stages are copied locally, as otherwise the compiler can't rule out that the stages are
+            // modified by writes into the blocks (which prevents keeping them in registers and vectorizing the loop)
+
+            auto local = stages;
+
+            for ( int i = 0; i < bufferSize; ++i ) {
+                process( local, channelData[ i ], i, std::index_sequence_for<Stages...>());
+            }
+        }
+
+    private:
+        std::tuple<Stages...> stages;
+
+        template <typename SampleType, size_t... Index>
+        static inline SampleType process( const std::tuple<Stages...>& local, SampleType sample, int index, std::index_sequence<Index...> )
+        {
+            (( sample = std::get<Index>( local ).process( sample, index )), ... );
+            return sample;
+        }
+};
+
+/* stages */
+
+// scales the block by a gain moving linearly from the start gain to the end gain over the block
+
+struct GainRamp
+{
+    GainRamp( float startGain, float endGain, int bufferSize ) :
+        start( startGain ), increment(( endGain - startGain ) / static_cast<float>( bufferSize )) {}
+
+    template <typename SampleType>
+    inline SampleType process( SampleType sample, int index ) const
+    {
+        return sample * ( start + increment * static_cast<float>( index ));
+    }
+
+    float start;
+    float increment;
+};
+
+// adds the block (scaled by given gain) to the output buffer
+
+template <typename SampleType>
+struct MixInto
+{
+    inline SampleType process( SampleType sample, int index ) const
+    {
+        output[ index ] += sample * gain;
+        return sample;
+    }
+
+    SampleType* output;
+    float gain;
+};
@@ -19,7 +19,8 @@
 
 /* constructor/destructor */
 
-DopplerEffect::DopplerEffect( double sampleRate, int bufferSize ) : rateInterpolator( 1.0f, INTERPOLATION_SPEED ), speedInterpolator( 1.f, INTERPOLATION_SPEED ), lfo( sampleRate )
+template <typename SampleType>
+DopplerEffect<SampleType>::DopplerEffect( double sampleRate, int bufferSize ) : rateInterpolator( 1.0f, INTERPOLATION_SPEED ), speedInterpolator( 1.f, INTERPOLATION_SPEED ), lfo( sampleRate )
 {
     lfo.setDepth( LFO_DEPTH );
 
@@ -35,8 +36,12 @@ DopplerEffect::DopplerEffect( double sampleRate, int bufferSize ) : rateInterpol
     setRecordingLength( maxDelay * 20 ); // multiplied the max value to give the read and write pointers some leeway
     
     maxRecordBufferSize = recordBufferSize; // recordBufferSize has been calculated by setRecordingLength()
-    recordBuffer.setSize( 1, maxRecordBufferSize );
-    recordBuffer.clear(); // fills buffer with silence
+    readBufferSize      = recordBufferSize;
+    dReadBufferSize     = dRecordBufferSize;
+
+    minRequiredSamplesInvert = static_cast<int>( _sampleRate / 32.f ); // subset
+
+    rateBuffer.resize( static_cast<size_t>( Parameters::Config::TILE_SIZE ));
 
     readPosition = 0;
     writePosition = 0;
@@ -44,14 +49,66 @@ DopplerEffect::DopplerEffect( double sampleRate, int bufferSize ) : rateInterpol
     processedSamples = 0;
 }
 
-DopplerEffect::~DopplerEffect()
+template <typename SampleType>
+DopplerEffect<SampleType>::~DopplerEffect()
 {
     // nowt...
 }
 
 /* public methods */
 
-void DopplerEffect::setProperties( float speed, bool invert, bool sync )
+template <typename SampleType>
+void DopplerEffect<SampleType>::allocate( float* memory, int recordSize )
+{
+    recordMemory = memory;
+    recordData   = reinterpret_cast<SampleType*>( memory );
+
+    if constexpr ( Parameters::Config::COMPRESS_HISTORY ) {
+        historyBlocks = reinterpret_cast<HistoryBlock*>( memory );
+    }
+    isRecordingSilent = true;
+
+    requestRecordSize( recordSize );
+    resetRecordBuffer(); // applies the requested size
+}
+
+template <typename SampleType>
+void DopplerEffect<SampleType>::release()
+{
+    recordMemory  = nullptr;
+    recordData    = nullptr;
+    historyBlocks = nullptr;
+}
+
+template <typename SampleType>
+int DopplerEffect<SampleType>::getRequiredRecordSize()
+{
+    // the read position drifts away from the write position at a speed determined by the deviation of the
+    // Doppler rate from unity (which scales with the LFO rate). The read position is only realigned with the
+    // write position (crossfaded at each beat) when synced to the tempo, otherwise it drifts freely and the
+    // full recording is required. When synced, the recording must hold the drift accumulated over a single
+    // beat, in addition to the lookahead required for upward shifts and the crossfade (as the read position is
+    // relative to the write position it was realigned with, the drift doesn't depend on where the write position was)
+
+    if ( !syncToBeat ) {
+        return maxRecordBufferSize;
+    }
+    float lfoRate = std::max( lfo.getRate(), Parameters::Config::LFO_MIN_RATE );
+    float minRate = juce::jlimit( MIN_DOPPLER_RATE, MAX_DOPPLER_RATE, ( SPEED_OF_SOUND - MAX_OBSERVER_DISTANCE * lfoRate * TWO_PI ) / SPEED_OF_SOUND );
+    float drift   = invertDirection ? 1.f - minRate : 1.f / minRate - 1.f;
+    float period  = static_cast<float>( std::min( syncPeriod.load(), maxRecordBufferSize )); // (unknown until the tempo is set)
+
+    float requiredSamples = drift * period + crossfadeSize + static_cast<float>( minRequiredSamplesInvert + Parameters::Config::TILE_SIZE );
+
+    // round up to whole history blocks
+
+    int recordSize = static_cast<int>( std::ceil( requiredSamples / HISTORY_BLOCK_SIZE )) * HISTORY_BLOCK_SIZE;
+
+    return std::min( recordSize, maxRecordBufferSize );
+}
+
+template <typename SampleType>
+void DopplerEffect<SampleType>::setProperties( float speed, bool invert, bool sync )
 {
     float scaledSpeed = juce::jmap( speed, 0.f, 1.f, Parameters::Config::LFO_MIN_RATE, Parameters::Config::LFO_MAX_RATE );
     lfo.setRate( scaledSpeed );
@@ -60,7 +117,14 @@ void DopplerEffect::setProperties( float speed, bool invert, bool sync )
     syncToBeat = sync;
 }
 
-void DopplerEffect::setRecordingLength( float durationInSeconds )
+template <typename SampleType>
+void DopplerEffect<SampleType>::setWaveform( int waveform )
+{
+    lfo.setWaveform( waveform );
+}
+
+template <typename SampleType>
+void DopplerEffect<SampleType>::setRecordingLength( float durationInSeconds )
 {
     int durationInSamples = Calc::secondsToBuffer( durationInSeconds, _sampleRate );
 
@@ -75,14 +139,15 @@ void DopplerEffect::setRecordingLength( float durationInSeconds )
     // make multiple of block bufferSize
     float fBufferSize = static_cast<float>( _bufferSize );
     recordBufferSize  = static_cast<int>( ceil( static_cast<float>( durationInSamples ) / fBufferSize ) * fBufferSize );
-    fRecordBufferSize = static_cast<float>( recordBufferSize );
+    dRecordBufferSize = static_cast<double>( recordBufferSize );
 
-    if ( writePosition > recordBufferSize ) {
+    if ( writePosition >= recordBufferSize ) {
         writePosition = 0;
     }
 }
 
-void DopplerEffect::updateTempo( double tempo, int timeSigNominator, int timeSigDenominator )
+template <typename SampleType>
+void DopplerEffect<SampleType>::updateTempo( double tempo, int timeSigNominator, int timeSigDenominator )
 {
     juce::ignoreUnused( timeSigNominator );
 
@@ -93,78 +158,174 @@ void DopplerEffect::updateTempo( double tempo, int timeSigNominator, int timeSig
     // Calculate the number of samples needed to perform an upwards Doppler shift, as this requires
     // reading "forward in time", e.g.: the buffer needs to be prefilled before we can start reading.
     
-    minRequiredSamplesInvert = static_cast<int>( _sampleRate / 32.f ); // subset
-    minRequiredSamples       = static_cast<int>( _sampleRate * MAX_LFO_CYCLE_DURATION * MAX_DOPPLER_RATE ); // full size buffer
+    minRequiredSamples = static_cast<int>( _sampleRate * MAX_LFO_CYCLE_DURATION * MAX_DOPPLER_RATE ); // full size buffer
    
     // convert the value to be a multiple of a single beat
     minRequiredSamples += ( minRequiredSamples % samplesPerBeat ); // ensure its larger than a single beat so it exceeds the above min
+    maxRequiredSamples = minRequiredSamples;
     minRequiredSamples = std::min( recordBufferSize, minRequiredSamples ); // keep within buffer bounds
 
+    syncPeriod.store( samplesPerBeat );
+
     resetRecordBuffer();
 }
 
-void DopplerEffect::onSequencerStart()
+template <typename SampleType>
+void DopplerEffect<SampleType>::onSequencerStart()
 {
     lfo.setPhase( 0.f );
     resetRecordBuffer();
 }
 
-void DopplerEffect::apply( juce::AudioBuffer<float>& buffer, int channel )
+template <typename SampleType>
+void DopplerEffect<SampleType>::apply( SampleType* channelData, int bufferSize )
 {
-    recordInput( buffer, channel );
-    
-    int bufferSize = buffer.getNumSamples();
-    
+    render( channelData, bufferSize, nullptr );
+}
+
+template <typename SampleType>
+void DopplerEffect<SampleType>::apply( SampleType* channelData, int bufferSize, const DopplerEffect& leader )
+{
+    render( channelData, bufferSize, &leader );
+}
+
+template <typename SampleType>
+void DopplerEffect<SampleType>::mirror( SampleType* channelData, int bufferSize, const DopplerEffect& leader, const SampleType* leaderOutput )
+{
+    // the recorded input equals the leaders, keep the history in sync so
+    // rendering can continue seamlessly once the inputs start to differ
+
+    recordInput( channelData, bufferSize );
+
+    if ( recordBufferSize != leader.recordBufferSize ) {
+        // the leader uses a different recording size, render individually until both have applied the same size
+        return renderOutput( channelData, bufferSize, &leader );
+    }
+
+    adoptModulation( leader );
+
+    readPosition          = leader.readPosition;
+    readOrigin            = leader.readOrigin;
+    syncedReadPosition    = leader.syncedReadPosition;
+    syncedOrigin          = leader.syncedOrigin;
+    writePosition         = leader.writePosition;
+    readFromRecordBuffer  = leader.readFromRecordBuffer;
+    totalRecordedSamples  = leader.totalRecordedSamples;
+    processedSamples      = leader.processedSamples;
+    previousSampleValue   = leader.previousSampleValue;
+    previousFilteredValue = leader.previousFilteredValue;
+    crossfadeSamplesLeft  = leader.crossfadeSamplesLeft;
+    crossfadedSamples     = leader.crossfadedSamples;
+    readBackward          = leader.readBackward;
+    readBufferSize        = leader.readBufferSize;
+    dReadBufferSize       = leader.dReadBufferSize;
+
+    if ( readBufferSize == recordBufferSize ) {
+        appliedRecordSize.store( recordBufferSize ); // no longer reading from a previous recording size
+    }
+    juce::FloatVectorOperations::copy( channelData, leaderOutput, bufferSize );
+}
+
+template <typename SampleType>
+void DopplerEffect<SampleType>::skip( int bufferSize )
+{
+    // the recording will only hold silence at this point, as such the
+    // record buffer doesn't need to be written, only the positions need to move
+
+    writePosition += bufferSize;
+
+    if ( writePosition >= recordBufferSize ) {
+        writePosition %= recordBufferSize;
+        applyRequestedRecordSize();
+    }
+
     if ( !readFromRecordBuffer ) {
-        // we first need n amount of samples recorded before we can start applying the effect
         totalRecordedSamples += bufferSize;
+        readFromRecordBuffer = totalRecordedSamples >= minRequiredSamples;
+        readBackward         = !readFromRecordBuffer;
+    }
 
-        if ( invertDirection && totalRecordedSamples < minRequiredSamplesInvert ) {
-            return;
-        }
+    lfo.skip( bufferSize );
 
-        if ( totalRecordedSamples >= minRequiredSamples ) {
-            readFromRecordBuffer = true;
-        } else if ( !invertDirection ) {
-            return; // need to fill up the record buffer even more before doing upward shifts
-        }
+    if ( crossfadeSamplesLeft > 0 ) {
+        crossfadeSamplesLeft = 0;
+        completeCrossfade();
     }
+    processedSamples = static_cast<int>(( static_cast<juce::int64>( processedSamples ) + bufferSize ) % samplesPerBeat );
+    readPosition += bufferSize;
 
-    float lfoRate = lfo.getRate();
+    rateBufferPosition = -1;
+}
 
-    if ( lfoRate == 0.f ) {
-        return onPostApply( bufferSize ); // nothing else to do
-    }
+template <typename SampleType>
+float DopplerEffect<SampleType>::getTailLength()
+{
+    // the full recording is read back, followed by the decay of the DC offset filter
 
-    auto* channelData = buffer.getWritePointer( channel );
+    float filterDecay = std::log( Parameters::Config::SILENCE_THRESHOLD ) / std::log( DC_OFFSET_FILTER );
 
-    float distanceMultiplier = lfoRate * TWO_PI;
+    return ( static_cast<float>( maxRecordBufferSize ) + filterDecay ) / _sampleRate;
+}
 
-    for ( int i = 0; i < bufferSize; ++i ) {
+/* private methods */
 
-        bool doCrossfade = crossfadeSamplesLeft > 0;
-        
-        // move the LFO and convert its position to a "distance in meters"
+template <typename SampleType>
+void DopplerEffect<SampleType>::render( SampleType* channelData, int bufferSize, const DopplerEffect* leader )
+{
+    recordInput( channelData, bufferSize );
+    renderOutput( channelData, bufferSize, leader );
+}
 
-        float observerDistance = juce::jmap( lfo.peek(), -1.0f, 1.0f, MIN_OBSERVER_DISTANCE, MAX_OBSERVER_DISTANCE );
-        
-        // apply circular motion to the listener to approximate their movement
+template <typename SampleType>
+void DopplerEffect<SampleType>::renderOutput( SampleType* channelData, int bufferSize, const DopplerEffect* leader )
+{
+    if ( !readFromRecordBuffer ) {
+        // upward shifts read "forward in time", which requires n amount of samples to be recorded first. Until then
+        // the recording is read backward in time (as with downward shifts, which only read what has been recorded)
+        // so the effect is applied from the first block, crossfading to the forward reads once enough is recorded
 
-        float observerSpeed = observerDistance * distanceMultiplier;
+        totalRecordedSamples += bufferSize;
 
-        if ( interpolateRate ) {
-            observerSpeed = speedInterpolator.setValue( observerSpeed );
-        }
-        float dopplerRate = juce::jlimit( MIN_DOPPLER_RATE, MAX_DOPPLER_RATE, ( SPEED_OF_SOUND - observerSpeed ) / SPEED_OF_SOUND );
+        if ( totalRecordedSamples >= minRequiredSamples ) {
+            readFromRecordBuffer = true;
 
-        if ( interpolateRate ) {
-            dopplerRate = rateInterpolator.setValue( dopplerRate );
+            if ( readBackward && !invertDirection ) {
+                crossfadeSamplesLeft = static_cast<int>( crossfadeSize );
+                crossfadedSamples    = 0;
+            } else {
+                readBackward = false;
+            }
         }
+    }
+
+    if ( lfo.getRate() == 0.f ) {
+        return onPostApply( bufferSize ); // nothing else to do
+    }
+
+    // use the rates of the linked leader when it has rendered them for this exact position
+
+    const SampleType* dopplerRates;
+
+    if ( leader != nullptr && leader->rateBufferPosition == readPosition && static_cast<int>( leader->rateBuffer.size()) >= bufferSize ) {
+        adoptModulation( *leader );
+        dopplerRates = leader->rateBuffer.data();
+    } else {
+        renderRates( bufferSize );
+        dopplerRates = rateBuffer.data(); // (once rendered, as the buffer grows for blocks exceeding the processing tile size)
+    }
+
+    for ( int i = 0; i < bufferSize; ++i ) {
+
+        bool doCrossfade  = crossfadeSamplesLeft > 0;
+        SampleType dopplerRate = dopplerRates[ i ];
        
-        float sampleValue = getResampledValue( dopplerRate, readPosition, i );
+        SampleType sampleValue = getResampledValue( dopplerRate, readOrigin, readPosition, i, readBufferSize, dReadBufferSize, readBackward );
 
         if ( doCrossfade ) {
-            float nextValue = getResampledValue( dopplerRate, getSyncedReadPosition(), i );
+            if ( crossfadedSamples == 0 ) {
+                alignSyncedReadPosition();
+            }
+            SampleType nextValue = getResampledValue( dopplerRate, syncedOrigin, syncedReadPosition, i, recordBufferSize, dRecordBufferSize, false );
             float mixFactor = crossfadedSamples / crossfadeSize;
 
             sampleValue = ( 1.0f - mixFactor ) * sampleValue + mixFactor * nextValue;
@@ -172,13 +333,13 @@ void DopplerEffect::apply( juce::AudioBuffer<float>& buffer, int channel )
             ++crossfadedSamples;
 
             if ( --crossfadeSamplesLeft == 0 ) {
-                readPosition = getSyncedReadPosition(); // crossfade complete, commit readPosition
+                completeCrossfade();
             }
         }
         
         // Apply a high-pass filter to remove DC offset
          
-        float filteredValue   = sampleValue - previousSampleValue + DC_OFFSET_FILTER * previousFilteredValue;
+        SampleType filteredValue = sampleValue - previousSampleValue + DC_OFFSET_FILTER * previousFilteredValue;
         previousSampleValue   = sampleValue;
         previousFilteredValue = filteredValue;
 
@@ -189,7 +350,7 @@ void DopplerEffect::apply( juce::AudioBuffer<float>& buffer, int channel )
         if ( ++processedSamples >= samplesPerBeat ) {
             processedSamples = 0;
 
-            if ( syncToBeat ) {
+            if ( syncToBeat && !readBackward ) {
                 crossfadeSamplesLeft = static_cast<int>( crossfadeSize );
                 crossfadedSamples = 0;
             }
@@ -198,53 +359,232 @@ void DopplerEffect::apply( juce::AudioBuffer<float>& buffer, int channel )
     onPostApply( bufferSize );
 }
 
-/* private methods */
-
-void DopplerEffect::recordInput( juce::AudioBuffer<float>& buffer, int channel )
+template <typename SampleType>
+void DopplerEffect<SampleType>::renderRates( int bufferSize )
 {
-    auto* channelData = buffer.getReadPointer( channel );
-    int bufferSize    = buffer.getNumSamples();
-    int writeEnd      = writePosition + bufferSize; // corresponds to the write index at start of the next iteration
+    if ( static_cast<int>( rateBuffer.size()) < bufferSize ) {
+        rateBuffer.resize( static_cast<size_t>( bufferSize )); // only when applied to blocks exceeding the processing tile size
+    }
+    rateBufferPosition = readPosition;
+
+    float distanceMultiplier = lfo.getRate() * TWO_PI;
+
+    // generate the LFO values for the entire block, these are converted to rates in place
 
-    bool shouldWrap = writeEnd >= recordBufferSize;
+    lfo.generate( rateBuffer.data(), bufferSize );
 
-    if ( shouldWrap ) {
-        // in certain situations (odd buffer size or in case host changes buffer size between process block
-        // calls) it is possible the end of the current recording iteration will exceed the record buffer size
-        // we can use a modulo operator to stay within bounds, but manually managing the loops overcomes
-        // potentially expensive divisor operations on the CPU
+    for ( int i = 0; i < bufferSize; ++i ) {
+        // convert the LFO position to a "distance in meters"
 
-        int samplesUntilWrap = recordBufferSize - writePosition;
+        SampleType observerDistance = juce::jmap<SampleType>( rateBuffer[ static_cast<size_t>( i )], -1, 1, MIN_OBSERVER_DISTANCE, MAX_OBSERVER_DISTANCE );
         
-        for ( int i = 0; i < samplesUntilWrap; ++i, ++writePosition ) {
-            recordBuffer.setSample( 0, writePosition, channelData[ i ]);
+        // apply circular motion to the listener to approximate their movement
+
+        SampleType observerSpeed = observerDistance * distanceMultiplier;
+
+        if ( interpolateRate ) {
+            observerSpeed = speedInterpolator.setValue( observerSpeed );
         }
+        SampleType dopplerRate = juce::jlimit<SampleType>( MIN_DOPPLER_RATE, MAX_DOPPLER_RATE, ( SPEED_OF_SOUND - observerSpeed ) / SPEED_OF_SOUND );
 
-        writePosition = 0;
-        for ( int i = samplesUntilWrap; i < bufferSize; ++i, ++writePosition ) {
-            recordBuffer.setSample( 0, writePosition, channelData[ i ]);
+        if ( interpolateRate ) {
+            dopplerRate = rateInterpolator.setValue( dopplerRate );
         }
-    } else {
-        for ( int i = 0; i < bufferSize; ++i, ++writePosition ) {
-            recordBuffer.setSample( 0, writePosition, channelData[ i ]);
+        rateBuffer[ static_cast<size_t>( i )] = dopplerRate;
+    }
+}
+
+template <typename SampleType>
+void DopplerEffect<SampleType>::adoptModulation( const DopplerEffect& leader )
+{
+    lfo               = leader.lfo;
+    rateInterpolator  = leader.rateInterpolator;
+    speedInterpolator = leader.speedInterpolator;
+}
+
+template <typename SampleType>
+void DopplerEffect<SampleType>::recordInput( const SampleType* channelData, int bufferSize )
+{
+    // in certain situations (odd buffer size or in case host changes buffer size between process block
+    // calls) it is possible the end of the current recording iteration will exceed the record buffer size
+    // we can use a modulo operator to stay within bounds, but copying contiguous ranges up until the
+    // wrap point overcomes potentially expensive divisor operations on the CPU (this also covers
+    // the unlikely case where the host provides blocks larger than the record buffer)
+
+    int readOffset = 0;
+    isRecordingSilent = false;
+
+    while ( readOffset < bufferSize ) {
+        int samplesToWrite = std::min( bufferSize - readOffset, recordBufferSize - writePosition );
+
+        if constexpr ( Parameters::Config::COMPRESS_HISTORY ) {
+            compressInput( channelData + readOffset, writePosition, samplesToWrite );
+        } else {
+            juce::FloatVectorOperations::copy( recordData + writePosition, channelData + readOffset, samplesToWrite );
+        }
+
+        readOffset    += samplesToWrite;
+        writePosition += samplesToWrite;
+
+        if ( writePosition >= recordBufferSize ) {
+            writePosition = 0;
+            applyRequestedRecordSize();
         }
     }
 }
 
-void DopplerEffect::resetRecordBuffer()
+template <typename SampleType>
+void DopplerEffect<SampleType>::compressInput( const SampleType* channelData, int position, int amount )
 {
-    recordBuffer.clear();
+    // quantize the input to 16-bit samples sharing a single scale per block. As the input does not necessarily
+    // start or end on a block boundary, a block can be partially overwritten. In that case the scale of the
+    // block must also cover its retained samples (which remain audible until overwritten in a later cycle)
+
+    while ( amount > 0 ) {
+        int block      = position >> Parameters::Config::HISTORY_BLOCK_SHIFT;
+        int blockStart = block << Parameters::Config::HISTORY_BLOCK_SHIFT;
+        int blockEnd   = std::min( blockStart + HISTORY_BLOCK_SIZE, recordBufferSize );
+        int writeEnd   = std::min( position + amount, blockEnd );
+        int count      = writeEnd - position;
+
+        auto range = juce::FloatVectorOperations::findMinAndMax( channelData, count );
+        float peak = static_cast<float>( std::max( std::abs( range.getStart()), std::abs( range.getEnd())));
+
+        auto& historyBlock   = historyBlocks[ block ];
+        float prevScale      = historyBlock.scale;
+        float scale          = peak / HISTORY_SAMPLE_MAX;
+        juce::int16* samples = historyBlock.samples;
+
+        if ( count < blockEnd - blockStart && prevScale > 0.f ) {
+            int retainedPeak = 0;
+            for ( int i = blockStart; i < blockEnd; ++i ) {
+                if ( i < position || i >= writeEnd ) {
+                    retainedPeak = std::max( retainedPeak, std::abs( static_cast<int>( samples[ i - blockStart ])));
+                }
+            }
+            scale = std::max( scale, static_cast<float>( retainedPeak ) * prevScale / HISTORY_SAMPLE_MAX );
+
+            if ( scale != prevScale ) {
+                float ratio = prevScale / scale;
+                for ( int i = 0; i < blockEnd - blockStart; ++i ) {
+                    float value = static_cast<float>( samples[ i ]) * ratio;
+                    samples[ i ] = static_cast<juce::int16>( value + std::copysign( 0.5f, value ));
+                }
+            }
+        }
+        historyBlock.scale = scale;
+
+        float multiplier = scale > 0.f ? 1.f / scale : 0.f;
+        juce::int16* output = samples + ( position - blockStart );
 
+        for ( int i = 0; i < count; ++i ) {
+            float value = static_cast<float>( channelData[ i ] * multiplier );
+            output[ i ] = static_cast<juce::int16>( value + std::copysign( 0.5f, value ));
+        }
+        channelData += count;
+        position    += count;
+        amount      -= count;
+    }
+}
+
+template <typename SampleType>
+void DopplerEffect<SampleType>::applyRequestedRecordSize()
+{
+    int recordSize = requestedRecordSize.load();
+
+    if ( recordSize <= 0 || readBufferSize != recordBufferSize ) {
+        return; // no size requested or still crossfading from the previous size
+    }
+
+    if ( recordSize != recordBufferSize ) {
+        recordBufferSize   = recordSize;
+        dRecordBufferSize  = static_cast<double>( recordSize );
+        minRequiredSamples = std::min( recordBufferSize, maxRequiredSamples );
+
+        if ( writePosition >= recordBufferSize ) {
+            writePosition = 0;
+        }
+
+        // when reading, crossfade from the read position within the previous size to the realigned read position
+        // (the memory of the previous size remains available until the crossfade has been completed)
+
+        if ( readFromRecordBuffer ) {
+            crossfadeSamplesLeft = static_cast<int>( crossfadeSize );
+            crossfadedSamples    = 0;
+            return;
+        }
+    }
+    readBufferSize  = recordBufferSize;
+    dReadBufferSize = dRecordBufferSize;
+
+    appliedRecordSize.store( recordSize );
+}
+
+template <typename SampleType>
+void DopplerEffect<SampleType>::alignSyncedReadPosition()
+{
+    // the position to crossfade to is fixed relative to the current write position when the crossfade starts
+    // (rather than following the write position, which jumps back when it wraps around the recording)
+
+    syncedOrigin       = writePosition;
+    syncedReadPosition = -( invertDirection ? minRequiredSamplesInvert : minRequiredSamples );
+}
+
+template <typename SampleType>
+void DopplerEffect<SampleType>::completeCrossfade()
+{
+    if ( crossfadedSamples == 0 ) {
+        alignSyncedReadPosition(); // completed before rendering any crossfaded sample (e.g. when skipping)
+    }
+    readOrigin   = syncedOrigin; // commit readPosition
+    readPosition = syncedReadPosition;
+    readBackward = false;
+
+    if ( readBufferSize != recordBufferSize ) {
+        readBufferSize  = recordBufferSize;
+        dReadBufferSize = dRecordBufferSize;
+
+        appliedRecordSize.store( recordBufferSize );
+    }
+}
+
+template <typename SampleType>
+void DopplerEffect<SampleType>::resetRecordBuffer()
+{
     readFromRecordBuffer = false;
+    readBackward         = true;
+
+    crossfadeSamplesLeft = 0; // abandon a running crossfade (e.g. to a new size)
+    readBufferSize  = recordBufferSize;
+    dReadBufferSize = dRecordBufferSize;
+
+    applyRequestedRecordSize();
+
+    // clearing the full recording is costly, it is skipped when the memory is known to be zeroed (e.g.
+    // when a newly enabled band is aligned with the tempo right after its memory has been committed)
+
+    if ( recordMemory != nullptr && !isRecordingSilent ) {
+        juce::FloatVectorOperations::clear( recordMemory, static_cast<int>( getMemorySize( recordBufferSize )));
+        isRecordingSilent = true;
+    }
+
     totalRecordedSamples = 0;
     processedSamples     = 0;
 
     writePosition = 0;
-    readPosition  = writePosition;
+    readOrigin    = writePosition;
+    readPosition  = 0;
+
+    rateBufferPosition = -1;
 }
 
-void DopplerEffect::onPostApply( int readBuffers )
+template <typename SampleType>
+void DopplerEffect<SampleType>::onPostApply( int readBuffers )
 {
     processedSamples += readBuffers;
     readPosition += readBuffers;
+    syncedReadPosition += readBuffers;
 }
+
+template class DopplerEffect<float>;
+template class DopplerEffect<double>;
@@ -16,73 +16,159 @@
  */
 #pragma once
 
+#include <atomic>
 #include <cmath>
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <limits>
+#include <vector>
 // #include "../interpolator/CubicInterpolator.h"
 #include "../interpolator/RateInterpolator.h"
 #include "../oscillator/LFO.h"
 #include "../../Parameters.h"
 
+/**
+ * Doppler effect rendering samples of given type. The recording, LFO and rate trajectory are kept in the same
+ * type, the (rarely changing) configuration remains single precision
+ */
+template <typename SampleType>
 class DopplerEffect
 {
-    const float MIN_DOPPLER_RATE       = 0.5f;
-    const float MAX_DOPPLER_RATE       = 2.0f;
-    const float MIN_OBSERVER_DISTANCE  = 1.f;
-    const float MAX_OBSERVER_DISTANCE  = 10.f;
-    const float SPEED_OF_SOUND         = 343.0f; // in m/s
-    const float TWO_PI                 = 2.f * juce::MathConstants<float>::pi;
-    const float DC_OFFSET_FILTER       = 0.995f;
-    const float MAX_LFO_CYCLE_DURATION = 1.0f / Parameters::Config::LFO_MIN_RATE; // duration of the slowest LFO cycle in seconds
-    const float LFO_DEPTH              = ( 1.f / MAX_OBSERVER_DISTANCE ) * 0.025f;
-    const float INTERPOLATION_SPEED    = 0.005f; // 0.0005f is interesting as it provides a tape slowdown effect
-    const float CROSSFADE_DURATION     = 0.01f; // in seconds
+    static constexpr float MIN_DOPPLER_RATE      = 0.5f;
+    static constexpr float MAX_DOPPLER_RATE      = 2.0f;
+    static constexpr float MIN_OBSERVER_DISTANCE = 1.f;
+    static constexpr float MAX_OBSERVER_DISTANCE = 10.f;
+    static constexpr float SPEED_OF_SOUND        = 343.0f; // in m/s
+    static constexpr float TWO_PI                = 2.f * juce::MathConstants<float>::pi;
+    static constexpr float DC_OFFSET_FILTER      = 0.995f;
+    static constexpr float LFO_DEPTH             = ( 1.f / MAX_OBSERVER_DISTANCE ) * 0.025f;
+    static constexpr float INTERPOLATION_SPEED   = 0.005f; // 0.0005f is interesting as it provides a tape slowdown effect
+    static constexpr float CROSSFADE_DURATION    = 0.01f; // in seconds
+    static inline const float MAX_LFO_CYCLE_DURATION = 1.0f / Parameters::Config::LFO_MIN_RATE; // duration of the slowest LFO cycle in seconds
+    static constexpr int HISTORY_BLOCK_SIZE          = 1 << Parameters::Config::HISTORY_BLOCK_SHIFT;
+    static constexpr float HISTORY_SAMPLE_MAX        = 32767.f;
+
+    // when compressed, the history is stored as consecutive blocks of samples sharing a single scale
+
+    struct HistoryBlock
+    {
+        float scale;
+        juce::int16 samples[ HISTORY_BLOCK_SIZE ];
+    };
 
     public:
         DopplerEffect( double sampleRate, int bufferSize );
         ~DopplerEffect();
 
         void setProperties( float speed, bool invert, bool sync );
+        void setWaveform( int waveform ); // see LFO::Waveform
         void setRecordingLength( float durationInSeconds );
         void updateTempo( double tempo, int timeSigNominator, int timeSigDenominator );
         void onSequencerStart();
 
-        // applies the Doppler effect onto the provided buffer at provided channel
-        // (Doppler effect applies onto individual (mono) channels, not groups)
+        // the amount of floats required to hold a recording of given size (in samples), when omitted
+        // the size of the longest possible recording (the memory to reserve for the effect)
+
+        inline size_t getMemorySize( int recordSize = 0 )
+        {
+            size_t samples = static_cast<size_t>( recordSize > 0 ? recordSize : maxRecordBufferSize );
+
+            if constexpr ( Parameters::Config::COMPRESS_HISTORY ) {
+                size_t blocks = ( samples + HISTORY_BLOCK_SIZE - 1 ) / HISTORY_BLOCK_SIZE;
+                return blocks * sizeof( HistoryBlock ) / sizeof( float );
+            }
+            return samples * sizeof( SampleType ) / sizeof( float );
+        }
+
+        // assigns/detaches the record buffer (the provided memory should hold getMemorySize( recordSize ) zeroed floats and is
+        // owned by the caller), the effect should not be applied (or have its tempo updated) while its buffer is released
+
+        void allocate( float* memory, int recordSize );
+        void release();
+
+        // the recording size (in samples) required for the current LFO rate, direction and beat sync period
+
+        int getRequiredRecordSize();
+
+        // requests the recording to be resized, which the effect applies once its recording wraps around (or is reset).
+        // When growing, the memory for the new size should be provided before requesting. When shrinking, the memory
+        // exceeding the new size should only be reclaimed once isRecordSizeApplied() confirms the effect no longer uses it
+
+        inline void requestRecordSize( int recordSize )
+        {
+            requestedRecordSize.store( recordSize );
+        }
+
+        inline bool isRecordSizeApplied()
+        {
+            return appliedRecordSize.load() == requestedRecordSize.load();
+        }
+
+        // applies the Doppler effect onto the provided (mono) channel data
+        // (Doppler effect applies onto individual channels, not groups)
+
+        void apply( SampleType* channelData, int bufferSize );
+
+        // applies the Doppler effect using the rate trajectory of a linked effect (e.g. the effect of another
+        // channel of the same band with equal LFO settings) which has already been applied for the current block.
+        // The modulation state of the leader is adopted, saving the LFO and rate interpolation computations
+
+        void apply( SampleType* channelData, int bufferSize, const DopplerEffect& leader );
+
+        // for a linked effect receiving input identical to the leader for at least the duration of the recording,
+        // records the input and adopts the leaders state and (provided) output instead of rendering the effect
+
+        void mirror( SampleType* channelData, int bufferSize, const DopplerEffect& leader, const SampleType* leaderOutput );
+
+        // advances the effect by given buffer size while receiving silence, without rendering any output
+        // (keeps the recording, LFO and beat positions aligned with the timeline while the effect is idle)
+
+        void skip( int bufferSize );
+
+        // the duration (in seconds) the effect keeps outputting audio after its input has become silent
 
-        void apply( juce::AudioBuffer<float>& buffer, int channel );
+        float getTailLength();
 
     private:
-        // CubicInterpolator cubicInterpolator;
-        RateInterpolator rateInterpolator;
-        RateInterpolator speedInterpolator;
-        LFO lfo;
-        bool interpolateRate = true;
-        
-        void recordInput( juce::AudioBuffer<float>& buffer, int channel );
+        void render( SampleType* channelData, int bufferSize, const DopplerEffect* leader );
+        void renderOutput( SampleType* channelData, int bufferSize, const DopplerEffect* leader );
+        void renderRates( int bufferSize );
+        void adoptModulation( const DopplerEffect& leader );
+        void recordInput( const SampleType* channelData, int bufferSize );
+        void compressInput( const SampleType* channelData, int position, int amount );
+        void applyRequestedRecordSize();
+        void alignSyncedReadPosition();
+        void completeCrossfade();
         void resetRecordBuffer();
         void onPostApply( int readBuffers );
 
-        inline float getResampledValue( float dopplerRate, int readPos, int readOffset )
+        inline SampleType getResampledValue( SampleType dopplerRate, int origin, juce::int64 readPos, int readOffset, int bufferSize, double dBufferSize, bool backward )
         {
-            float resampledIndex;
+            double resampledIndex;
 
-            // calculate the read index of the sample inside the record buffer
+            // calculate the read index of the sample inside the record buffer, where only the read position relative
+            // to the write position it was aligned with (origin) is scaled by the rate. Scaling the full index would
+            // make the distance to the write position depend on where the write position was when aligning
+            // (in double precision as the read position keeps increasing during long sessions, where
+            // single precision would lose the fractional part of the index after a few minutes of playback)
 
-            if ( invertDirection ) {
-                resampledIndex = ( readPos + readOffset ) * dopplerRate;
+            if ( invertDirection || backward ) {
+                resampledIndex = static_cast<double>( origin ) + static_cast<double>( readPos + readOffset ) * dopplerRate;
             } else {
-                resampledIndex = ( readPos + readOffset ) / dopplerRate;
+                resampledIndex = static_cast<double>( origin ) + static_cast<double>( readPos + readOffset ) / dopplerRate;
             }
     
             // ensure the resampleIndex remains within record bounds
 
-            resampledIndex = fmod( resampledIndex, fRecordBufferSize );
+            resampledIndex = fmod( resampledIndex, dBufferSize );
             if ( resampledIndex < 0 ) {
-                resampledIndex += fRecordBufferSize;
+                resampledIndex += dBufferSize;
             }
             int index  = static_cast<int>( resampledIndex );
-            float frac = resampledIndex - static_cast<float>( index );
+            SampleType frac = static_cast<SampleType>( resampledIndex - static_cast<double>( index ));
+
+            if ( index >= bufferSize ) {
+                index -= bufferSize; // rounding of negative positions can land exactly on the upper bound
+            }
 
             // calculate sample value using (more accurate) cubic interpolation
 
@@ -90,39 +176,73 @@ class DopplerEffect
 
             // calculate sample value using (faster) linear interpolation
             
-            int nextIndex = ( index + 1 ) % recordBufferSize;
-            float sampleValue = recordBuffer.getSample( 0, index ) * ( 1.0f - frac ) +
-                                recordBuffer.getSample( 0, nextIndex ) * frac;
+            int nextIndex = ( index + 1 ) % bufferSize;
+            SampleType sampleValue = getRecordedSample( index ) * ( SampleType( 1 ) - frac ) + getRecordedSample( nextIndex ) * frac;
 
             return sampleValue;
         }
 
-        inline int getSyncedReadPosition()
+        inline SampleType getRecordedSample( int index )
         {
-            return writePosition - ( invertDirection ? minRequiredSamplesInvert : minRequiredSamples );
+            if constexpr ( Parameters::Config::COMPRESS_HISTORY ) {
+                const auto& block = historyBlocks[ index >> Parameters::Config::HISTORY_BLOCK_SHIFT ];
+                return static_cast<float>( block.samples[ index & ( HISTORY_BLOCK_SIZE - 1 )]) * block.scale;
+            }
+            return recordData[ index ];
         }
-        
-        juce::AudioBuffer<float> recordBuffer;
-        float fRecordBufferSize;
+
+        // state that is updated for every rendered sample is kept together at the start of the object,
+        // followed by the state read during rendering and lastly the rarely accessed configuration
+
+        juce::int64 readPosition = 0; // relative to readOrigin
+        int readOrigin = 0;           // the write position the read position was last aligned with
+        int writePosition = 0;
+        int processedSamples;
+        int crossfadeSamplesLeft;
+        int crossfadedSamples;
+        juce::int64 syncedReadPosition = 0; // the read position crossfaded to, relative to syncedOrigin
+        int syncedOrigin = 0;
+        SampleType previousSampleValue   = 0;
+        SampleType previousFilteredValue = 0;
+
+        RateInterpolator<SampleType> rateInterpolator;
+        RateInterpolator<SampleType> speedInterpolator;
+        LFO<SampleType> lfo;
+        // CubicInterpolator cubicInterpolator;
+
+        float* recordMemory = nullptr; // the memory provided by allocate() (nullptr while released)
+        SampleType* recordData = nullptr; // the record buffer: recordMemory interpreted as samples
+        HistoryBlock* historyBlocks = nullptr; // when compressed: recordMemory interpreted as history blocks
+        double dRecordBufferSize;
         int recordBufferSize;
-        int maxRecordBufferSize = 0;
-        int readPosition;
-        int writePosition;
+        double dReadBufferSize; // the recording size read from, differs from recordBufferSize
+        int readBufferSize;     // while crossfading after the recording has been resized
+        int samplesPerBeat = std::numeric_limits<int>::max();
+        float crossfadeSize;
         bool invertDirection = true;
         bool syncToBeat = false;
-        
+        bool interpolateRate = true;
         bool readFromRecordBuffer = false;
+        bool readBackward = true; // while warming up, see renderOutput()
+        bool isRecordingSilent = false; // nothing was recorded since the memory was provided or cleared (no need to clear it)
         int totalRecordedSamples;
-        int processedSamples;
         int minRequiredSamples;
+        int maxRequiredSamples = std::numeric_limits<int>::max(); // minRequiredSamples prior to being limited to the recording size
         int minRequiredSamplesInvert;
-        int samplesPerBeat = std::numeric_limits<int>::max();
 
-        float previousSampleValue   = 0.0f;
-        float previousFilteredValue = 0.0f;
-        float crossfadeSize;
-        int crossfadeSamplesLeft;
-        int crossfadedSamples;
+        // the Doppler rate for each sample of the current block, along with the read position
+        // it was rendered for (allowing linked effects to verify they are in lockstep)
+
+        std::vector<SampleType> rateBuffer;
+        juce::int64 rateBufferPosition = -1;
+
+        int maxRecordBufferSize = 0;
+
+        // recording size handshake, requested by the message thread and applied by the audio thread
+
+        std::atomic<int> requestedRecordSize { 0 };
+        std::atomic<int> appliedRecordSize   { 0 };
+        std::atomic<int> syncPeriod          { std::numeric_limits<int>::max() }; // samplesPerBeat, readable by the message thread
 
         float _sampleRate;
         int   _bufferSize;
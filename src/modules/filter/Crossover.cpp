@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "Crossover.h"
+
+Crossover::Crossover()
+{
+    for ( int i = 0; i < MAX_SPLITS; ++i ) {
+        splits.add( new FilterBank( 2 ));
+    }
+}
+
+/* public methods */
+
+void Crossover::State::reset()
+{
+    for ( auto& split : splits ) {
+        split.reset();
+    }
+}
+
+void Crossover::setSimdLevel( int level )
+{
+    for ( auto* split : splits ) {
+        split->setSimdLevel( level );
+    }
+}
+
+void Crossover::setFrequencies( const float* frequencies, int amountOfSplits, double sampleRate )
+{
+    // a fourth order Linkwitz-Riley filter consists of two cascaded Butterworth filters, the sum of its
+    // low and high pass equals a second order allpass at the crossover frequency (with a Butterworth Q)
+
+    static const double BUTTERWORTH_Q = 1.0 / std::sqrt( 2.0 );
+
+    juce::IIRCoefficients coefficients[ FilterBank::MAX_LANES * 2 ];
+
+    for ( int index = 0; index < std::min( amountOfSplits, MAX_SPLITS ); ++index ) {
+        double frequency = std::min( static_cast<double>( frequencies[ index ]), sampleRate * 0.45 ); // remain below Nyquist
+
+        auto lowPass  = juce::IIRCoefficients::makeLowPass ( sampleRate, frequency, BUTTERWORTH_Q );
+        auto highPass = juce::IIRCoefficients::makeHighPass( sampleRate, frequency, BUTTERWORTH_Q );
+        auto allPass  = juce::IIRCoefficients::makeAllPass ( sampleRate, frequency, BUTTERWORTH_Q );
+
+        coefficients[ LANE_LOW_PASS  * 2 ] = coefficients[ LANE_LOW_PASS  * 2 + 1 ] = lowPass;
+        coefficients[ LANE_HIGH_PASS * 2 ] = coefficients[ LANE_HIGH_PASS * 2 + 1 ] = highPass;
+
+        // each band below this split (but the one it splits off) passes through its allpass response
+
+        int amountOfLanes = LANE_ALLPASS + index;
+
+        for ( int lane = LANE_ALLPASS; lane < amountOfLanes; ++lane ) {
+            coefficients[ lane * 2 ]     = allPass;
+            coefficients[ lane * 2 + 1 ] = FilterBank::makeIdentity();
+        }
+        splits[ index ]->setCoefficients( coefficients, amountOfLanes );
+    }
+}
+
+void Crossover::split( State& state, const float* input, float* const* bands, int amountOfBands, int bufferSize )
+{
+    int lastBand = amountOfBands - 1;
+
+    // the remainder of the signal (which is yet to be split) is kept in the last band
+
+    if ( bands[ lastBand ] != input ) {
+        juce::FloatVectorOperations::copy( bands[ lastBand ], input, bufferSize );
+    }
+
+    float* lanes[ FilterBank::MAX_LANES ];
+
+    for ( int index = 0; index < std::min( lastBand, MAX_SPLITS ); ++index ) {
+        // split the remainder into the band at this index (low pass) and the new remainder (high pass)
+
+        juce::FloatVectorOperations::copy( bands[ index ], bands[ lastBand ], bufferSize );
+
+        lanes[ LANE_LOW_PASS ]  = bands[ index ];
+        lanes[ LANE_HIGH_PASS ] = bands[ lastBand ];
+
+        for ( int band = 0; band < index; ++band ) {
+            lanes[ LANE_ALLPASS + band ] = bands[ band ];
+        }
+        splits[ index ]->process( state.splits[ index ], lanes, LANE_ALLPASS + index, bufferSize );
+    }
+}
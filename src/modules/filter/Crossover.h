@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "FilterBank.h"
+
+/**
+ * Splits a signal into bands using a tree of fourth order Linkwitz-Riley crossovers. The signal is split at
+ * the lowest frequency first, after which the high passed remainder is split at the next frequency, and so on.
+ * The bands that were split off earlier are passed through the allpass response of each subsequent split, so
+ * all bands remain phase aligned and their sum equals the (allpass filtered) input, e.g. the bands sum flat.
+ *
+ * Each split is a two stage FilterBank, filtering its low pass, high pass and the allpass compensation
+ * of the lower bands in parallel. The coefficients are shared by all channels, the state is kept per channel.
+ */
+class Crossover
+{
+    public:
+        static constexpr int MAX_BANDS  = Parameters::Config::MAX_BANDS;
+        static constexpr int MAX_SPLITS = MAX_BANDS - 1;
+
+        struct State
+        {
+            FilterBank::State splits[ MAX_SPLITS ];
+
+            void reset();
+        };
+
+        Crossover();
+
+        // sets the split frequencies (in Hz, ascending) for given amount of splits (e.g. the amount of bands - 1)
+        // remaining splits keep their current frequencies. Not to be called during rendering
+
+        void setFrequencies( const float* frequencies, int amountOfSplits, double sampleRate );
+
+        // splits the input into given amount of bands, the input can equal the last band (when rendering in place)
+
+        void split( State& state, const float* input, float* const* bands, int amountOfBands, int bufferSize );
+
+        // selects the variant of the filter kernels for given instruction set (see Simd). Not to be called during rendering
+
+        void setSimdLevel( int level );
+
+    private:
+        static const int LANE_LOW_PASS  = 0;
+        static const int LANE_HIGH_PASS = 1;
+        static const int LANE_ALLPASS   = 2; // first lane compensating the bands split off previously
+
+        juce::OwnedArray<FilterBank> splits;
+
+        JUCE_DECLARE_NON_COPYABLE( Crossover )
+};
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "FilterBank.h"
+
+FilterBank::FilterBank( int amountOfStages ) : numStages( juce::jlimit( 1, MAX_STAGES, amountOfStages ))
+{
+    std::fill( std::begin( interleaved ), std::end( interleaved ), 0.f );
+    setSimdLevel( Simd::LEVEL_BASELINE );
+}
+
+/* public methods */
+
+void FilterBank::State::reset()
+{
+    for ( int stage = 0; stage < MAX_STAGES; ++stage ) {
+        std::fill( std::begin( v1[ stage ]), std::end( v1[ stage ]), 0.f );
+        std::fill( std::begin( v2[ stage ]), std::end( v2[ stage ]), 0.f );
+    }
+}
+
+void FilterBank::State::reset( int lane )
+{
+    for ( int stage = 0; stage < MAX_STAGES; ++stage ) {
+        v1[ stage ][ lane ] = 0.f;
+        v2[ stage ][ lane ] = 0.f;
+    }
+}
+
+void FilterBank::setCoefficients( const juce::IIRCoefficients* coefficients, int amountOfLanes )
+{
+    // acquire the pending coefficients (the audio thread only holds them briefly while copying)
+
+    int state = handoffState.load();
+
+    while ( state == HANDOFF_WRITING || state == HANDOFF_READING || !handoffState.compare_exchange_weak( state, HANDOFF_WRITING )) {
+        juce::Thread::yield();
+        state = handoffState.load();
+    }
+
+    for ( int lane = 0; lane < std::min( amountOfLanes, MAX_LANES ); ++lane ) {
+        for ( int stage = 0; stage < numStages; ++stage ) {
+            // normalized coefficients in the order b0, b1, b2, a1, a2
+
+            auto& source = coefficients[ lane * numStages + stage ].coefficients;
+
+            pendingCoefficients.b0[ stage ][ lane ] = source[ 0 ];
+            pendingCoefficients.b1[ stage ][ lane ] = source[ 1 ];
+            pendingCoefficients.b2[ stage ][ lane ] = source[ 2 ];
+            pendingCoefficients.a1[ stage ][ lane ] = source[ 3 ];
+            pendingCoefficients.a2[ stage ][ lane ] = source[ 4 ];
+        }
+    }
+    handoffState.store( HANDOFF_PENDING );
+}
+
+juce::IIRCoefficients FilterBank::makeIdentity()
+{
+    return juce::IIRCoefficients( 1.0, 0.0, 0.0, 1.0, 0.0, 0.0 );
+}
+
+void FilterBank::process( State& state, float* const* lanes, int amountOfLanes, int bufferSize )
+{
+    pickUpCoefficients();
+
+    ( this->*variant )( state, lanes, amountOfLanes, bufferSize );
+}
+
+void FilterBank::setSimdLevel( int level )
+{
+    variant = Simd::select<Variant>( level, &FilterBank::filterBaseline, &FilterBank::filterAvx2, &FilterBank::filterAvx512 );
+}
+
+/* private methods */
+
+DELIRION_TARGET_BASELINE void FilterBank::filterBaseline( State& state, float* const* lanes, int amountOfLanes, int bufferSize )
+{
+    filterLanes<GROUP_SIZE>( state, lanes, amountOfLanes, bufferSize );
+}
+
+DELIRION_TARGET_AVX2 void FilterBank::filterAvx2( State& state, float* const* lanes, int amountOfLanes, int bufferSize )
+{
+    filterLanes<WIDE_GROUP_SIZE>( state, lanes, amountOfLanes, bufferSize );
+}
+
+// (as MAX_LANES equals the width of an AVX register, AVX-512 only adds its additional registers and encodings)
+
+DELIRION_TARGET_AVX512 void FilterBank::filterAvx512( State& state, float* const* lanes, int amountOfLanes, int bufferSize )
+{
+    filterLanes<WIDE_GROUP_SIZE>( state, lanes, amountOfLanes, bufferSize );
+}
+
+template <int GroupSize>
+void FilterBank::filterLanes( State& state, float* const* lanes, int amountOfLanes, int bufferSize )
+{
+    // only the groups containing used lanes are filtered, wide groups are only used when
+    // more lanes are used than fit a single narrow group (as these would otherwise filter unused lanes)
+
+    static_assert( MAX_LANES % GroupSize == 0, "lanes must divide into groups" );
+
+    bool isWide = GroupSize > GROUP_SIZE && amountOfLanes > GROUP_SIZE;
+    int groupSize      = isWide ? GroupSize : GROUP_SIZE;
+    int amountOfGroups = ( amountOfLanes + groupSize - 1 ) / groupSize;
+
+    for ( int offset = 0; offset < bufferSize; offset += MAX_FRAMES ) {
+        int frames = std::min( MAX_FRAMES, bufferSize - offset );
+
+        for ( int lane = 0; lane < amountOfLanes; ++lane ) {
+            if ( lanes[ lane ] == nullptr ) {
+                continue;
+            }
+            const float* input = lanes[ lane ] + offset;
+
+            for ( int i = 0; i < frames; ++i ) {
+                interleaved[ i * MAX_LANES + lane ] = input[ i ];
+            }
+        }
+
+        for ( int group = 0; group < amountOfGroups; ++group ) {
+            if ( isWide ) {
+                if ( numStages == 1 ) {
+                    filterGroup<1, GroupSize>( state, group * GroupSize, frames );
+                } else {
+                    filterGroup<2, GroupSize>( state, group * GroupSize, frames );
+                }
+            } else if ( numStages == 1 ) {
+                filterGroup<1, GROUP_SIZE>( state, group * GROUP_SIZE, frames );
+            } else {
+                filterGroup<2, GROUP_SIZE>( state, group * GROUP_SIZE, frames );
+            }
+        }
+
+        for ( int lane = 0; lane < amountOfLanes; ++lane ) {
+            if ( lanes[ lane ] == nullptr ) {
+                continue;
+            }
+            float* output = lanes[ lane ] + offset;
+
+            for ( int i = 0; i < frames; ++i ) {
+                output[ i ] = interleaved[ i * MAX_LANES + lane ];
+            }
+        }
+    }
+}
+
+template <int Stages, int GroupSize>
+void FilterBank::filterGroup( State& state, int firstLane, int frames )
+{
+    // the coefficients and state of the group are copied into locals of a fixed size so the
+    // compiler can keep these in (vector) registers for the duration of the recursion
+
+    float b0[ Stages ][ GroupSize ], b1[ Stages ][ GroupSize ], b2[ Stages ][ GroupSize ];
+    float a1[ Stages ][ GroupSize ], a2[ Stages ][ GroupSize ];
+    float v1[ Stages ][ GroupSize ], v2[ Stages ][ GroupSize ];
+
+    for ( int stage = 0; stage < Stages; ++stage ) {
+        for ( int lane = 0; lane < GroupSize; ++lane ) {
+            b0[ stage ][ lane ] = activeCoefficients.b0[ stage ][ firstLane + lane ];
+            b1[ stage ][ lane ] = activeCoefficients.b1[ stage ][ firstLane + lane ];
+            b2[ stage ][ lane ] = activeCoefficients.b2[ stage ][ firstLane + lane ];
+            a1[ stage ][ lane ] = activeCoefficients.a1[ stage ][ firstLane + lane ];
+            a2[ stage ][ lane ] = activeCoefficients.a2[ stage ][ firstLane + lane ];
+            v1[ stage ][ lane ] = state.v1[ stage ][ firstLane + lane ];
+            v2[ stage ][ lane ] = state.v2[ stage ][ firstLane + lane ];
+        }
+    }
+
+    // transposed direct form II, all lanes of the group are processed (lanes without coefficients output silence)
+
+    for ( int i = 0; i < frames; ++i ) {
+        float* frame = interleaved + i * MAX_LANES + firstLane;
+
+        for ( int stage = 0; stage < Stages; ++stage ) {
+            for ( int lane = 0; lane < GroupSize; ++lane ) {
+                float in  = frame[ lane ];
+                float out = b0[ stage ][ lane ] * in + v1[ stage ][ lane ];
+
+                v1[ stage ][ lane ] = b1[ stage ][ lane ] * in - a1[ stage ][ lane ] * out + v2[ stage ][ lane ];
+                v2[ stage ][ lane ] = b2[ stage ][ lane ] * in - a2[ stage ][ lane ] * out;
+
+                frame[ lane ] = out;
+            }
+        }
+    }
+
+    for ( int stage = 0; stage < Stages; ++stage ) {
+        for ( int lane = 0; lane < GroupSize; ++lane ) {
+            state.v1[ stage ][ firstLane + lane ] = v1[ stage ][ lane ];
+            state.v2[ stage ][ firstLane + lane ] = v2[ stage ][ lane ];
+        }
+    }
+}
+
+void FilterBank::pickUpCoefficients()
+{
+    int expected = HANDOFF_PENDING;
+
+    if ( handoffState.compare_exchange_strong( expected, HANDOFF_READING )) {
+        activeCoefficients = pendingCoefficients;
+        handoffState.store( HANDOFF_IDLE );
+    }
+    // when the coefficients are being written, the current coefficients are used for this block
+}
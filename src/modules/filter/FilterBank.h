@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "../../Parameters.h"
+#include "../../utils/Simd.h"
+#include <atomic>
+
+/**
+ * A bank of biquad filters (one per band, or lane) which are processed in parallel. The samples of all lanes are
+ * interleaved so each frame is filtered for (a group of) all lanes at once, letting the compiler vectorize the
+ * filter recursion across the lanes (one lane per SIMD lane) rather than running a dependent recursion per lane.
+ * Each lane can consist of a cascade of (up to MAX_STAGES) biquads, e.g. to form fourth order filters.
+ *
+ * The coefficients are shared by all channels, the filter state is kept per channel (see State).
+ * Coefficients are provided by a non-audio thread and picked up by the audio thread at the start of process().
+ */
+class FilterBank
+{
+    public:
+        static constexpr int MAX_LANES  = Parameters::Config::MAX_BANDS;
+        static constexpr int MAX_STAGES = 2;
+
+        struct alignas( 32 ) State
+        {
+            float v1[ MAX_STAGES ][ MAX_LANES ] = {};
+            float v2[ MAX_STAGES ][ MAX_LANES ] = {};
+
+            void reset();
+            void reset( int lane );
+        };
+
+        FilterBank( int amountOfStages = 1 );
+
+        // sets the coefficients of the first amountOfLanes lanes (remaining lanes keep their current coefficients),
+        // ordered by lane and then by stage (e.g. coefficients[ lane * amountOfStages + stage ]).
+        // Never blocks the audio thread. Not to be called during rendering
+
+        void setCoefficients( const juce::IIRCoefficients* coefficients, int amountOfLanes );
+
+        // coefficients passing the signal through unchanged (e.g. for lanes requiring less stages)
+        static juce::IIRCoefficients makeIdentity();
+
+        // filters given lanes in place, lanes can be nullptr when not rendered (their state is then undefined
+        // and should be reset before they are rendered again)
+
+        void process( State& state, float* const* lanes, int amountOfLanes, int bufferSize );
+
+        // selects the variant of the filter kernel for given instruction set (see Simd). Not to be called during rendering
+
+        void setSimdLevel( int level );
+
+    private:
+        static constexpr int MAX_FRAMES = 64; // frames interleaved at a time (keeps the interleaved buffer L1 resident)
+        static constexpr int GROUP_SIZE = 4;  // lanes filtered together (e.g. the width of a SSE/NEON register)
+        static constexpr int WIDE_GROUP_SIZE = 8; // idem, for AVX registers (used when filtering more than GROUP_SIZE lanes)
+
+        enum HandoffState { HANDOFF_IDLE = 0, HANDOFF_WRITING, HANDOFF_PENDING, HANDOFF_READING };
+
+        struct alignas( 32 ) Coefficients
+        {
+            float b0[ MAX_STAGES ][ MAX_LANES ] = {};
+            float b1[ MAX_STAGES ][ MAX_LANES ] = {};
+            float b2[ MAX_STAGES ][ MAX_LANES ] = {};
+            float a1[ MAX_STAGES ][ MAX_LANES ] = {};
+            float a2[ MAX_STAGES ][ MAX_LANES ] = {};
+        };
+
+        int numStages;
+
+        Coefficients activeCoefficients;  // used by the audio thread
+        Coefficients pendingCoefficients; // written by the message thread
+        std::atomic<int> handoffState { HANDOFF_IDLE };
+
+        alignas( 32 ) float interleaved[ MAX_FRAMES * MAX_LANES ];
+
+        using Variant = void ( FilterBank::* )( State&, float* const*, int, int );
+        Variant variant;
+
+        void pickUpCoefficients();
+
+        template <int GroupSize>
+        void filterLanes( State& state, float* const* lanes, int amountOfLanes, int bufferSize );
+
+        template <int Stages, int GroupSize>
+        void filterGroup( State& state, int firstLane, int frames );
+
+        void filterBaseline( State& state, float* const* lanes, int amountOfLanes, int bufferSize );
+        void filterAvx2    ( State& state, float* const* lanes, int amountOfLanes, int bufferSize );
+        void filterAvx512  ( State& state, float* const* lanes, int amountOfLanes, int bufferSize );
+
+        JUCE_DECLARE_NON_COPYABLE( FilterBank )
+};
@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "LinearPhaseCrossover.h"
+
+LinearPhaseCrossover::State::State( double sampleRate ) : numPartitions( LinearPhaseCrossover::getNumPartitions( sampleRate ))
+{
+    inputFrame.resize( PARTITION_SIZE * 2, 0.f );
+    spectra.resize( static_cast<size_t>( numPartitions * NUM_BINS * 2 ), 0.f );
+    bandOutput.resize( PARTITION_SIZE * MAX_BANDS, 0.f );
+    dryDelay.resize( static_cast<size_t>( PARTITION_SIZE + numPartitions * PARTITION_SIZE / 2 - 1 ), 0.f );
+}
+
+LinearPhaseCrossover::LinearPhaseCrossover( double sampleRate ) :
+    _sampleRate( sampleRate ),
+    numPartitions( getNumPartitions( sampleRate )),
+    fft( FFT_ORDER )
+{
+    // the filters are designed by transforming their (zero phase) frequency response, sampled at twice the filter length
+
+    int designOrder = 1;
+
+    while (( 1 << designOrder ) < numPartitions * PARTITION_SIZE * 2 ) {
+        ++designOrder;
+    }
+    designFFT = std::make_unique<juce::dsp::FFT>( designOrder );
+
+    for ( auto& set : masks ) {
+        set.resize( static_cast<size_t>( MAX_BANDS * numPartitions * NUM_BINS * 2 ), 0.f );
+    }
+    transformBuffer.resize( FFT_SIZE * 2, 0.f );
+    spectrumBuffer.resize( NUM_BINS * 2, 0.f );
+}
+
+/* public methods */
+
+void LinearPhaseCrossover::State::reset()
+{
+    std::fill( inputFrame.begin(), inputFrame.end(), 0.f );
+    std::fill( spectra.begin(),    spectra.end(),    0.f );
+    std::fill( bandOutput.begin(), bandOutput.end(), 0.f );
+    std::fill( dryDelay.begin(),   dryDelay.end(),   0.f );
+}
+
+void LinearPhaseCrossover::State::reset( int band )
+{
+    std::fill_n( bandOutput.begin() + band * PARTITION_SIZE, PARTITION_SIZE, 0.f );
+}
+
+int LinearPhaseCrossover::getLatency() const
+{
+    // the current partition is rendered once it has been received in full, in addition the
+    // (symmetric) filters delay their input by half their length
+
+    return PARTITION_SIZE + numPartitions * PARTITION_SIZE / 2 - 1;
+}
+
+void LinearPhaseCrossover::setFrequencies( const float* frequencies, int amountOfSplits )
+{
+    amountOfSplits = std::min( amountOfSplits, MAX_BANDS - 1 );
+
+    if ( designedFrequencies.size() == static_cast<size_t>( amountOfSplits ) &&
+         std::equal( designedFrequencies.begin(), designedFrequencies.end(), frequencies )) {
+        return;
+    }
+
+    // acquire the set of masks the audio thread isn't using (it only holds the handoff briefly while swapping sets)
+
+    int state = handoffState.load();
+
+    while ( state == HANDOFF_WRITING || state == HANDOFF_READING || !handoffState.compare_exchange_weak( state, HANDOFF_WRITING )) {
+        juce::Thread::yield();
+        state = handoffState.load();
+    }
+
+    auto& target  = masks[ 1 - activeMasks ];
+    auto& current = masks[ activeMasks ];
+    size_t bandSize = static_cast<size_t>( numPartitions * NUM_BINS * 2 );
+
+    for ( int band = 0; band < MAX_BANDS; ++band ) {
+        if ( band <= amountOfSplits ) {
+            designMask( band, amountOfSplits, frequencies, target.data() + band * bandSize );
+        } else {
+            // bands beyond the band count keep their current mask while they fade out
+            std::copy_n( current.begin() + static_cast<long>( band * bandSize ), bandSize, target.begin() + static_cast<long>( band * bandSize ));
+        }
+    }
+    handoffState.store( HANDOFF_PENDING );
+
+    designedFrequencies.assign( frequencies, frequencies + amountOfSplits );
+}
+
+void LinearPhaseCrossover::split( State& state, float* channelData, float* const* bands, int amountOfBands, int bufferSize )
+{
+    pickUpMasks();
+
+    int dryDelaySize = static_cast<int>( state.dryDelay.size());
+
+    for ( int offset = 0; offset < bufferSize; ) {
+        int frames   = std::min( PARTITION_SIZE - state.position, bufferSize - offset );
+        float* input = channelData + offset;
+
+        // collect the input and replace it with the delayed input
+
+        std::copy_n( input, frames, state.inputFrame.begin() + PARTITION_SIZE + state.position );
+
+        for ( int i = 0; i < frames; ++i ) {
+            float delayed = state.dryDelay[ static_cast<size_t>( state.dryDelayIndex )];
+            state.dryDelay[ static_cast<size_t>( state.dryDelayIndex )] = input[ i ];
+            input[ i ] = delayed;
+
+            if ( ++state.dryDelayIndex == dryDelaySize ) {
+                state.dryDelayIndex = 0;
+            }
+        }
+
+        // write the bands from the previously rendered partition (after the dry signal, as bands can render in place)
+
+        for ( int band = 0; band < amountOfBands; ++band ) {
+            if ( bands[ band ] != nullptr ) {
+                std::copy_n( state.bandOutput.begin() + band * PARTITION_SIZE + state.position, frames, bands[ band ] + offset );
+            }
+        }
+
+        state.position += frames;
+        offset += frames;
+
+        if ( state.position == PARTITION_SIZE ) {
+            processPartition( state, bands, amountOfBands );
+            state.position = 0;
+        }
+    }
+}
+
+/* private methods */
+
+int LinearPhaseCrossover::getNumPartitions( double sampleRate )
+{
+    return std::max( 1, static_cast<int>( std::ceil( FILTER_DURATION * sampleRate / PARTITION_SIZE )));
+}
+
+void LinearPhaseCrossover::designMask( int band, int amountOfSplits, const float* frequencies, float* mask )
+{
+    int designSize = designFFT->getSize();
+    int length     = numPartitions * PARTITION_SIZE;
+    int center     = length / 2 - 1; // the last tap remains zero so the filter is symmetric around its center
+
+    std::vector<float> response( static_cast<size_t>( designSize * 2 ), 0.f );
+
+    // the magnitude of the fourth order Linkwitz-Riley response of the band within the crossover tree (the
+    // low pass of its own split, preceded by the high passes of all splits below it). As each low and high
+    // pass pair sums to unity, the responses of all bands sum to unity
+
+    for ( int bin = 0; bin <= designSize / 2; ++bin ) {
+        double frequency = static_cast<double>( bin ) * _sampleRate / static_cast<double>( designSize );
+        double magnitude = 1.0;
+
+        for ( int split = 0; split <= std::min( band, amountOfSplits - 1 ); ++split ) {
+            double ratio   = std::pow( frequency / static_cast<double>( frequencies[ split ]), 4.0 );
+            double lowPass = 1.0 / ( 1.0 + ratio );
+
+            magnitude *= split == band ? lowPass : 1.0 - lowPass;
+        }
+        response[ static_cast<size_t>( bin * 2 )] = static_cast<float>( magnitude );
+    }
+    designFFT->performRealOnlyInverseTransform( response.data());
+
+    // center the (zero phase) impulse response within the filter length and window it
+
+    std::vector<float> taps( static_cast<size_t>( length ), 0.f );
+
+    for ( int tap = 0; tap < length - 1; ++tap ) {
+        double window = 0.5 - 0.5 * std::cos( juce::MathConstants<double>::twoPi * static_cast<double>( tap + 1 ) / static_cast<double>( length ));
+        taps[ static_cast<size_t>( tap )] = response[ static_cast<size_t>(( tap - center + designSize ) % designSize )] * static_cast<float>( window );
+    }
+
+    // transform each partition of the filter (zero padded to the transform size)
+
+    std::vector<float> partition( FFT_SIZE * 2 );
+
+    for ( int index = 0; index < numPartitions; ++index ) {
+        std::fill( partition.begin(), partition.end(), 0.f );
+        std::copy_n( taps.begin() + index * PARTITION_SIZE, PARTITION_SIZE, partition.begin());
+
+        fft.performRealOnlyForwardTransform( partition.data(), true );
+
+        float* real      = mask + index * NUM_BINS * 2;
+        float* imaginary = real + NUM_BINS;
+
+        for ( int bin = 0; bin < NUM_BINS; ++bin ) {
+            real[ bin ]      = partition[ static_cast<size_t>( bin * 2 )];
+            imaginary[ bin ] = partition[ static_cast<size_t>( bin * 2 + 1 )];
+        }
+    }
+}
+
+void LinearPhaseCrossover::processPartition( State& state, float* const* bands, int amountOfBands )
+{
+    // transform the last two partitions of the input once and add the spectrum to the delay line
+
+    std::copy( state.inputFrame.begin(), state.inputFrame.end(), transformBuffer.begin());
+    fft.performRealOnlyForwardTransform( transformBuffer.data(), true );
+
+    state.lastSpectrum = ( state.lastSpectrum + 1 ) % state.numPartitions;
+
+    float* spectrum = state.spectra.data() + state.lastSpectrum * NUM_BINS * 2;
+
+    for ( int bin = 0; bin < NUM_BINS; ++bin ) {
+        spectrum[ bin ]            = transformBuffer[ static_cast<size_t>( bin * 2 )];
+        spectrum[ NUM_BINS + bin ] = transformBuffer[ static_cast<size_t>( bin * 2 + 1 )];
+    }
+
+    // the current partition becomes the previous partition of the next frame
+
+    std::copy_n( state.inputFrame.begin() + PARTITION_SIZE, PARTITION_SIZE, state.inputFrame.begin());
+
+    // for each rendered band, multiply the delayed spectra with the corresponding partitions of its mask
+
+    float* sumReal      = spectrumBuffer.data();
+    float* sumImaginary = sumReal + NUM_BINS;
+
+    for ( int band = 0; band < amountOfBands; ++band ) {
+        if ( bands[ band ] == nullptr ) {
+            continue;
+        }
+        const float* mask = masks[ activeMasks ].data() + band * numPartitions * NUM_BINS * 2;
+
+        std::fill( spectrumBuffer.begin(), spectrumBuffer.end(), 0.f );
+
+        for ( int index = 0; index < state.numPartitions; ++index ) {
+            int delayed = ( state.lastSpectrum - index + state.numPartitions ) % state.numPartitions;
+
+            const float* inputReal      = state.spectra.data() + delayed * NUM_BINS * 2;
+            const float* inputImaginary = inputReal + NUM_BINS;
+            const float* maskReal       = mask + index * NUM_BINS * 2;
+            const float* maskImaginary  = maskReal + NUM_BINS;
+
+            for ( int bin = 0; bin < NUM_BINS; ++bin ) {
+                sumReal[ bin ]      += inputReal[ bin ] * maskReal[ bin ] - inputImaginary[ bin ] * maskImaginary[ bin ];
+                sumImaginary[ bin ] += inputReal[ bin ] * maskImaginary[ bin ] + inputImaginary[ bin ] * maskReal[ bin ];
+            }
+        }
+
+        for ( int bin = 0; bin < NUM_BINS; ++bin ) {
+            transformBuffer[ static_cast<size_t>( bin * 2 )]     = sumReal[ bin ];
+            transformBuffer[ static_cast<size_t>( bin * 2 + 1 )] = sumImaginary[ bin ];
+        }
+        fft.performRealOnlyInverseTransform( transformBuffer.data());
+
+        // the first half of the frame is circularly aliased, the second half is the output for the partition
+
+        std::copy_n( transformBuffer.begin() + PARTITION_SIZE, PARTITION_SIZE, state.bandOutput.begin() + band * PARTITION_SIZE );
+    }
+}
+
+void LinearPhaseCrossover::pickUpMasks()
+{
+    int expected = HANDOFF_PENDING;
+
+    if ( handoffState.compare_exchange_strong( expected, HANDOFF_READING )) {
+        activeMasks = 1 - activeMasks;
+        handoffState.store( HANDOFF_IDLE );
+    }
+    // when the masks are being designed, the current masks are used for this block
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_dsp/juce_dsp.h>
+#include "../../Parameters.h"
+#include <atomic>
+#include <vector>
+
+/**
+ * Splits a signal into bands using linear phase FIR filters, applied in the frequency domain using
+ * uniformly partitioned overlap-save convolution. The input is transformed once per partition, after
+ * which the spectrum of each band is obtained by applying its mask (the partitioned spectrum of its filter).
+ *
+ * The band masks have the magnitude response of a fourth order Linkwitz-Riley crossover tree without its phase
+ * response, so the bands sum to the input delayed by the latency (see getLatency()). The dry signal is delayed
+ * by the same amount so it remains aligned with the bands.
+ *
+ * The masks are shared by all channels, the state is kept per channel (see State). Masks are designed by a
+ * non-audio thread and picked up by the audio thread at the start of split().
+ */
+class LinearPhaseCrossover
+{
+    public:
+        static const int MAX_BANDS = Parameters::Config::MAX_BANDS;
+
+        // the input is processed in partitions of this amount of samples, the filters span (about) FILTER_DURATION
+
+        static const int PARTITION_SIZE = 256;
+        static constexpr double FILTER_DURATION = 0.09; // in seconds, e.g. a resolution of ~11 Hz
+
+        class State
+        {
+            public:
+                State( double sampleRate );
+
+                void reset();
+                void reset( int band );
+
+            private:
+                friend class LinearPhaseCrossover;
+
+                int numPartitions;
+                int position = 0;   // within the current partition
+                int lastSpectrum = 0; // index of the most recent spectrum within the delay line
+
+                std::vector<float> inputFrame;      // previous and current partition of the input
+                std::vector<float> spectra;         // frequency domain delay line, numPartitions spectra (real and imaginary parts)
+                std::vector<float> bandOutput;      // last rendered partition of each band
+                std::vector<float> dryDelay;        // the input, delayed by the latency
+                int dryDelayIndex = 0;
+        };
+
+        LinearPhaseCrossover( double sampleRate );
+
+        // the amount of samples by which the bands (and dry signal) are delayed
+
+        int getLatency() const;
+
+        // designs the band masks for given split frequencies (in Hz, ascending) for given amount of splits (e.g. the
+        // amount of bands - 1). Does nothing when the frequencies are unchanged. Not to be called during rendering
+
+        void setFrequencies( const float* frequencies, int amountOfSplits );
+
+        // splits channelData into given amount of bands, after which channelData contains the delayed input.
+        // bands can be nullptr when not rendered and equal channelData (when rendering in place)
+
+        void split( State& state, float* channelData, float* const* bands, int amountOfBands, int bufferSize );
+
+    private:
+        static const int FFT_ORDER = 9; // transforms two partitions
+        static const int FFT_SIZE  = PARTITION_SIZE * 2;
+        static const int NUM_BINS  = FFT_SIZE / 2 + 1;
+
+        enum HandoffState { HANDOFF_IDLE = 0, HANDOFF_WRITING, HANDOFF_PENDING, HANDOFF_READING };
+
+        double _sampleRate;
+        int numPartitions;
+
+        juce::dsp::FFT fft;
+        std::unique_ptr<juce::dsp::FFT> designFFT; // transforms the full filter length
+
+        // the masks of all bands (per band, numPartitions spectra of real and imaginary parts). Two sets are
+        // kept, the message thread designs into the set the audio thread isn't reading
+
+        std::vector<float> masks[ 2 ];
+        int activeMasks = 0;
+        std::atomic<int> handoffState { HANDOFF_IDLE };
+
+        std::vector<float> designedFrequencies; // the split frequencies of the last design, empty when not designed
+
+        // shared by all channels as these are rendered in succession
+
+        std::vector<float> transformBuffer;
+        std::vector<float> spectrumBuffer;
+
+        static int getNumPartitions( double sampleRate );
+
+        void designMask( int band, int amountOfSplits, const float* frequencies, float* mask );
+        void processPartition( State& state, float* const* bands, int amountOfBands );
+        void pickUpMasks();
+
+        JUCE_DECLARE_NON_COPYABLE( LinearPhaseCrossover )
+};
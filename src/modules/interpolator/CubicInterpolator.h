@@ -18,27 +18,28 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 
+template <typename SampleType>
 class CubicInterpolator
 {
     public:
         CubicInterpolator() {}
 
-        inline float interpolate( float y0, float y1, float y2, float y3, float x )
+        inline SampleType interpolate( SampleType y0, SampleType y1, SampleType y2, SampleType y3, SampleType x )
         {
-            return y1 + 0.5f * x * ( y2 - y0 + x * ( 2.0f * y0 - 5.0f * y1 + 4.0f * y2 - y3 + x * ( 3.0f * ( y1 - y2 ) + y3 - y0 )));
+            return y1 + SampleType( 0.5 ) * x * ( y2 - y0 + x * ( SampleType( 2 ) * y0 - SampleType( 5 ) * y1 + SampleType( 4 ) * y2 - y3 + x * ( SampleType( 3 ) * ( y1 - y2 ) + y3 - y0 )));
         }
 
-        inline float getInterpolatedSample( juce::AudioBuffer<float>& buffer, int bufferSize, int index, float frac )
+        inline SampleType getInterpolatedSample( juce::AudioBuffer<SampleType>& buffer, int bufferSize, int index, SampleType frac )
         {
             int prevIndex1 = ( index - 1 + bufferSize ) % bufferSize;
             int prevIndex2 = ( index - 2 + bufferSize ) % bufferSize;
             int nextIndex1 = ( index + 1 ) % bufferSize;
             int nextIndex2 = ( index + 2 ) % bufferSize;
 
-            float y0 = ( prevIndex2 < 0 || prevIndex2 >= bufferSize ) ? lastNextNextSample : buffer.getSample( 0, prevIndex2 );
-            float y1 = ( prevIndex1 < 0 || prevIndex1 >= bufferSize ) ? lastNextSample : buffer.getSample( 0, prevIndex1 );
-            float y2 = ( index < 0 || index >= bufferSize ) ? lastSample : buffer.getSample( 0, index );
-            float y3 = ( nextIndex1 < 0 || nextIndex1 >= bufferSize ) ? 0.0f : buffer.getSample( 0, nextIndex1 );
+            SampleType y0 = ( prevIndex2 < 0 || prevIndex2 >= bufferSize ) ? lastNextNextSample : buffer.getSample( 0, prevIndex2 );
+            SampleType y1 = ( prevIndex1 < 0 || prevIndex1 >= bufferSize ) ? lastNextSample : buffer.getSample( 0, prevIndex1 );
+            SampleType y2 = ( index < 0 || index >= bufferSize ) ? lastSample : buffer.getSample( 0, index );
+            SampleType y3 = ( nextIndex1 < 0 || nextIndex1 >= bufferSize ) ? SampleType( 0 ) : buffer.getSample( 0, nextIndex1 );
 
             lastSample         = buffer.getSample( 0, index );
             lastNextSample     = buffer.getSample( 0, nextIndex1 );
@@ -48,7 +49,7 @@ class CubicInterpolator
         }
 
     private:
-        float lastSample         = 0.f;
-        float lastNextSample     = 0.f;
-        float lastNextNextSample = 0.f;
+        SampleType lastSample         = 0;
+        SampleType lastNextSample     = 0;
+        SampleType lastNextNextSample = 0;
 };
@@ -20,13 +20,14 @@
  * A class that interpolates changes to oscillator speed (rate) values
  * to create a smoother transition
  */
+template <typename SampleType>
 class RateInterpolator
 {
     public:
-        RateInterpolator( float initialValue, float aSmoothingFactor )
+        RateInterpolator( SampleType initialValue, SampleType aSmoothingFactor )
             : currentValue( initialValue ), targetValue( initialValue ), smoothingFactor( aSmoothingFactor ) {}
 
-        inline float setValue( float newValue )
+        inline SampleType setValue( SampleType newValue )
         {
             targetValue   = newValue;
             currentValue += smoothingFactor * ( targetValue - currentValue );
@@ -35,7 +36,7 @@ class RateInterpolator
         }
 
     private:
-        float currentValue;
-        float targetValue;
-        float smoothingFactor;
+        SampleType currentValue;
+        SampleType targetValue;
+        SampleType smoothingFactor;
 };
@@ -17,49 +17,190 @@
 #include "LFO.h"
 #include "../../Parameters.h"
 
-LFO::LFO( double sampleRate )
+template <typename SampleType>
+LFO<SampleType>::LFO( double sampleRate )
 {
-    _sampleRate = static_cast<float>( sampleRate );
-    _depth      = 1.f;
-    _phase      = 0.f;
+    _sampleRate = static_cast<SampleType>( sampleRate );
+    _depth      = 1;
+    _phase      = 0;
 
     setRate( Parameters::Config::LFO_MIN_RATE );
 }
 
-LFO::~LFO()
+template <typename SampleType>
+LFO<SampleType>::~LFO()
 {
 
 }
 
 /* public methods */
 
-float LFO::getRate()
+template <typename SampleType>
+float LFO<SampleType>::getRate()
 {
     return _rate;
 }
 
-void LFO::setRate( float value )
+template <typename SampleType>
+void LFO<SampleType>::setRate( float value )
 {
     _rate = value;
-    _targetIncrement = _rate / _sampleRate;
+    _targetIncrement = static_cast<SampleType>( _rate ) / _sampleRate;
 }
 
-float LFO::getDepth()
+template <typename SampleType>
+SampleType LFO<SampleType>::getDepth()
 {
     return _depth;
 }
 
-void LFO::setDepth( float value )
+template <typename SampleType>
+void LFO<SampleType>::setDepth( SampleType value )
 {
     _depth = value;
 }
 
-float LFO::getPhase()
+template <typename SampleType>
+SampleType LFO<SampleType>::getPhase()
 {
     return _phase;
 }
 
-void LFO::setPhase( float value )
+template <typename SampleType>
+void LFO<SampleType>::setPhase( SampleType value )
 {
     _phase = value;
 }
+
+template <typename SampleType>
+int LFO<SampleType>::getWaveform()
+{
+    return _waveform;
+}
+
+template <typename SampleType>
+void LFO<SampleType>::setWaveform( int value )
+{
+    _waveform = juce::jlimit( 0, NUM_WAVEFORMS - 1, value );
+}
+
+template <typename SampleType>
+void LFO<SampleType>::skip( int amountOfSamples )
+{
+    _phaseIncrement = _targetIncrement; // any smoothing will have completed during the skipped range
+    advancePhase( _phaseIncrement * static_cast<SampleType>( amountOfSamples ));
+}
+
+template <typename SampleType>
+void LFO<SampleType>::generate( SampleType* output, int amountOfSamples )
+{
+    int offset = 0;
+
+    // while the rate is being smoothed, the increment changes for every sample
+
+    while ( offset < amountOfSamples && _phaseIncrement != _targetIncrement ) {
+        _phaseIncrement += _smoothingFactor * ( _targetIncrement - _phaseIncrement );
+
+        if ( std::abs( _targetIncrement - _phaseIncrement ) < SMOOTHING_THRESHOLD ) {
+            _phaseIncrement = _targetIncrement;
+        }
+        output[ offset++ ] = getValue( _phase );
+        advancePhase( _phaseIncrement );
+    }
+
+    if ( offset == amountOfSamples ) {
+        return;
+    }
+
+    // at a constant increment the remainder is generated in bulk
+
+    if ( _waveform == WAVEFORM_SINE ) {
+        return generateSine( output + offset, amountOfSamples - offset );
+    }
+
+    while ( offset < amountOfSamples ) {
+        // split the range at the cycle boundaries
+
+        int remaining = amountOfSamples - offset;
+        int toBoundary = _phaseIncrement > 0 ? static_cast<int>( std::ceil(( 1 - _phase ) / _phaseIncrement )) : remaining;
+        int amount = juce::jlimit( 1, remaining, toBoundary );
+
+        generateSegment( output + offset, amount );
+        offset += amount;
+    }
+}
+
+/* private methods */
+
+template <typename SampleType>
+void LFO<SampleType>::generateSine( SampleType* output, int amountOfSamples )
+{
+    // the sine is generated by rotating a phasor (e.g. complex multiplication) rather than evaluating the sine
+    // for each sample. To allow vectorization, LANES consecutive phasors are each rotated by LANES increments.
+    // The phasors are derived from the phase at the start of each block, so rounding errors don't accumulate
+
+    if ( _rotationIncrement != _phaseIncrement ) {
+        _rotationIncrement = _phaseIncrement;
+        _rotationSin = std::sin( TWO_PI * _phaseIncrement * LANES );
+        _rotationCos = std::cos( TWO_PI * _phaseIncrement * LANES );
+    }
+
+    SampleType sine  [ LANES ];
+    SampleType cosine[ LANES ];
+
+    for ( int lane = 0; lane < LANES; ++lane ) {
+        SampleType phase = TWO_PI * ( _phase + _phaseIncrement * static_cast<SampleType>( lane ));
+        sine  [ lane ]   = std::sin( phase );
+        cosine[ lane ]   = std::cos( phase );
+    }
+
+    int i = 0;
+
+    for ( ; i + LANES <= amountOfSamples; i += LANES ) {
+        for ( int lane = 0; lane < LANES; ++lane ) {
+            output[ i + lane ] = sine[ lane ] * _depth;
+
+            SampleType rotatedSine = sine[ lane ] * _rotationCos + cosine[ lane ] * _rotationSin;
+            cosine[ lane ]         = cosine[ lane ] * _rotationCos - sine[ lane ] * _rotationSin;
+            sine  [ lane ]         = rotatedSine;
+        }
+    }
+
+    for ( int lane = 0; i < amountOfSamples; ++i, ++lane ) {
+        output[ i ] = sine[ lane ] * _depth;
+    }
+    advancePhase( _phaseIncrement * static_cast<SampleType>( amountOfSamples ));
+}
+
+template <typename SampleType>
+void LFO<SampleType>::generateSegment( SampleType* output, int amountOfSamples )
+{
+    if ( _waveform == WAVEFORM_TRIANGLE ) {
+        for ( int i = 0; i < amountOfSamples; ++i ) {
+            output[ i ] = getTriangle( std::min( _phase + _phaseIncrement * static_cast<SampleType>( i ), SampleType( 1 ))) * _depth;
+        }
+    } else {
+        for ( int i = 0; i < amountOfSamples; ++i ) {
+            output[ i ] = getRandom( std::min( _phase + _phaseIncrement * static_cast<SampleType>( i ), SampleType( 1 ))) * _depth;
+        }
+    }
+    advancePhase( _phaseIncrement * static_cast<SampleType>( amountOfSamples ));
+}
+
+template <typename SampleType>
+void LFO<SampleType>::advancePhase( SampleType amount )
+{
+    _phase += amount;
+
+    if ( _phase >= 1 ) {
+        _phase -= std::floor( _phase );
+
+        // a new cycle starts, determine the next random value
+
+        _randomStart = _randomEnd;
+        _randomEnd   = _random.nextFloat() * 2.f - 1.f;
+    }
+}
+
+template class LFO<float>;
+template class LFO<double>;
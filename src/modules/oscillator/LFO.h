@@ -18,48 +18,99 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 
+/**
+ * Low frequency oscillator rendering samples of given type. The phase is accumulated in the
+ * same type, so in double precision it keeps its accuracy over long sessions.
+ */
+template <typename SampleType>
 class LFO
 {
     public:
+        enum Waveform { WAVEFORM_SINE = 0, WAVEFORM_TRIANGLE, WAVEFORM_RANDOM, NUM_WAVEFORMS };
+
         LFO( double sampleRate );
         ~LFO();
 
         float getRate();
         void setRate( float value );
 
-        float getDepth();
-        void setDepth( float value );
+        SampleType getDepth();
+        void setDepth( SampleType value );
+
+        SampleType getPhase();
+        void setPhase( SampleType value );
 
-        float getPhase();
-        void setPhase( float value );
+        int getWaveform();
+        void setWaveform( int value );
+
+        // advances the phase by given amount of samples without generating values
+        void skip( int amountOfSamples );
 
         /**
-         * retrieve a value from the wave table for the current
-         * phase position, this method also increments
-         * the phase and keeps it within bounds
+         * writes the values for given amount of samples into the output buffer,
+         * advancing the phase (and keeping it within bounds) accordingly
          */
-        inline float peek()
-        {
-            _phaseIncrement += _smoothingFactor * ( _targetIncrement - _phaseIncrement );
+        void generate( SampleType* output, int amountOfSamples );
+
+    private:
+        static constexpr SampleType TWO_PI              = 2 * juce::MathConstants<SampleType>::pi;
+        static constexpr SampleType SMOOTHING_THRESHOLD = static_cast<SampleType>( 1.e-9 ); // below which the increment snaps to its target
+        static constexpr int        LANES               = 4; // sine values rendered in parallel (see generateSine())
 
-            float lfoValue = std::sin( TWO_PI * _phase ) * _depth;
-            
-            _phase += _phaseIncrement;
+        // value of the waveform at given phase (used while the phase increment is being smoothed)
 
-            if ( _phase >= 1.0f ) {
-                _phase -= 1.0f;
+        inline SampleType getValue( SampleType phase )
+        {
+            switch ( _waveform ) {
+                default:
+                case WAVEFORM_SINE:
+                    return std::sin( TWO_PI * phase ) * _depth;
+                case WAVEFORM_TRIANGLE:
+                    return getTriangle( phase ) * _depth;
+                case WAVEFORM_RANDOM:
+                    return getRandom( phase ) * _depth;
             }
-            return lfoValue;
         }
 
-    private:
-        const float TWO_PI  = 2.f * juce::MathConstants<float>::pi;
-
-        float _sampleRate;
-        float _rate;
-        float _depth;
-        float _phase;
-        float _phaseIncrement = 0.f;
-        float _targetIncrement = 0.f;
-        float _smoothingFactor = 0.01f;
+        // triangle aligned with the sine (zero at the start of the cycle, rising to its peak at a quarter)
+
+        inline SampleType getTriangle( SampleType phase )
+        {
+            SampleType shiftedPhase = phase + 0.25f;
+            shiftedPhase -= shiftedPhase >= 1.f ? 1.f : 0.f;
+
+            return 1.f - 4.f * std::abs( shiftedPhase - 0.5f );
+        }
+
+        // smooth (cubic) transition from the previous random value to the next over a single cycle
+
+        inline SampleType getRandom( SampleType phase )
+        {
+            return _randomStart + ( _randomEnd - _randomStart ) * phase * phase * ( 3.f - 2.f * phase );
+        }
+
+        void generateSine( SampleType* output, int amountOfSamples );
+        void generateSegment( SampleType* output, int amountOfSamples ); // does not cross a cycle boundary
+        void advancePhase( SampleType amount );
+
+        SampleType _sampleRate;
+        float      _rate;
+        SampleType _depth;
+        SampleType _phase;
+        SampleType _phaseIncrement  = 0;
+        SampleType _targetIncrement = 0;
+        SampleType _smoothingFactor = static_cast<SampleType>( 0.01 );
+        int        _waveform = WAVEFORM_SINE;
+
+        // rotation by LANES phase increments (cached for the increment it was calculated for)
+
+        SampleType _rotationIncrement = -1;
+        SampleType _rotationSin = 0;
+        SampleType _rotationCos = 1;
+
+        // start and end values of the current random cycle
+
+        SampleType _randomStart = 0;
+        SampleType _randomEnd   = 0;
+        juce::Random _random;
 };
@@ -22,31 +22,39 @@
  */
 #include "Allpass.h"
 
-AllPass::AllPass()
+template <typename SampleType>
+AllPass<SampleType>::AllPass()
 {
     _bufIndex = 0;
     setFeedback( 0.5f );
 }
 
-void AllPass::setBuffer( float *buf, int size )
+template <typename SampleType>
+void AllPass<SampleType>::setBuffer( SampleType *buf, int size )
 {
     _buffer  = buf;
     _bufSize = size;
 }
 
-void AllPass::mute()
+template <typename SampleType>
+void AllPass<SampleType>::mute()
 {
     for ( int i = 0; i < _bufSize; i++ ) {
-        _buffer[ i ] = 0.f;
+        _buffer[ i ] = 0;
     }
 }
 
-float AllPass::getFeedback()
+template <typename SampleType>
+SampleType AllPass<SampleType>::getFeedback()
 {
     return _feedback;
 }
 
-void AllPass::setFeedback( float val )
+template <typename SampleType>
+void AllPass<SampleType>::setFeedback( SampleType val )
 {
     _feedback = val;
 }
+
+template class AllPass<float>;
+template class AllPass<double>;
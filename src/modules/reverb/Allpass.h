@@ -16,15 +16,16 @@
  */
 #pragma once
 
+template <typename SampleType>
 class AllPass
 {
     public:
         AllPass();
-        void setBuffer( float *buf, int size );
-        inline float process( float input )
+        void setBuffer( SampleType *buf, int size );
+        inline SampleType process( SampleType input )
         {
-            float output;
-            float bufout = _buffer[ _bufIndex ];
+            SampleType output;
+            SampleType bufout = _buffer[ _bufIndex ];
             // undenormalise( bufout );
 
             output = -input + bufout;
@@ -36,12 +37,12 @@ class AllPass
             return output;
         }
         void mute();
-        float getFeedback();
-        void setFeedback( float val );
+        SampleType getFeedback();
+        void setFeedback( SampleType val );
 
     private:
-        float  _feedback;
-        float* _buffer;
+        SampleType  _feedback;
+        SampleType* _buffer;
         int _bufSize;
         int _bufIndex;
 };
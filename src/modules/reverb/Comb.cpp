@@ -22,43 +22,52 @@
  */
 #include "Comb.h"
 
-Comb::Comb()
+template <typename SampleType>
+Comb<SampleType>::Comb()
 {
     _filterStore = 0;
     _bufIndex    = 0;
 }
 
-void Comb::setBuffer( float* buffer, int size )
+template <typename SampleType>
+void Comb<SampleType>::setBuffer( SampleType* buffer, int size )
 {
     _buffer  = buffer;
     _bufSize = size;
 }
 
-void Comb::mute()
+template <typename SampleType>
+void Comb<SampleType>::mute()
 {
     for ( int i = 0; i < _bufSize; i++ ) {
-        _buffer[ i ] = 0.f;
+        _buffer[ i ] = 0;
     }
 }
 
-float Comb::getDamp()
+template <typename SampleType>
+SampleType Comb<SampleType>::getDamp()
 {
     return _damp1;
 }
 
-void Comb::setDamp( float val )
+template <typename SampleType>
+void Comb<SampleType>::setDamp( SampleType val )
 {
     _damp1 = val;
     _damp2 = 1 - val;
 }
 
-float Comb::getFeedback()
+template <typename SampleType>
+SampleType Comb<SampleType>::getFeedback()
 {
     return _feedback;
 }
 
-void Comb::setFeedback( float val )
+template <typename SampleType>
+void Comb<SampleType>::setFeedback( SampleType val )
 {
     _feedback = val;
 }
 
+template class Comb<float>;
+template class Comb<double>;
@@ -16,14 +16,19 @@
  */
 #pragma once
 
+template <typename SampleType> class Reverb;
+
+template <typename SampleType>
 class Comb
 {
+    friend class Reverb<SampleType>; // renders all combs of its bank at once (see Reverb::render())
+
     public:
         Comb();
-        void setBuffer( float *buf, int size );
-        inline float process( float input )
+        void setBuffer( SampleType *buf, int size );
+        inline SampleType process( SampleType input )
         {
-            float output = _buffer[ _bufIndex ];
+            SampleType output = _buffer[ _bufIndex ];
             // undenormalise( output );
 
             _filterStore = ( output * _damp2 ) + ( _filterStore * _damp1 );
@@ -36,17 +41,17 @@ class Comb
             return output;
         }
         void mute();
-        float getDamp();
-        void setDamp( float val );
-        float getFeedback();
-        void setFeedback( float val );
+        SampleType getDamp();
+        void setDamp( SampleType val );
+        SampleType getFeedback();
+        void setFeedback( SampleType val );
 
     private:
-        float  _feedback;
-        float  _filterStore;
-        float  _damp1;
-        float  _damp2;
-        float* _buffer;
+        SampleType  _feedback;
+        SampleType  _filterStore;
+        SampleType  _damp1;
+        SampleType  _damp2;
+        SampleType* _buffer;
         int _bufSize;
         int _bufIndex;
 };
@@ -0,0 +1,624 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ConvolutionReverb.h"
+#include "../../utils/Calc.h"
+
+ConvolutionReverb::ConvolutionReverb( double sampleRate, int amountOfChannels ) :
+    juce::Thread( "Delirion convolution tail" ),
+    _sampleRate( sampleRate ),
+    headFFT( HEAD_FFT_ORDER ),
+    tailFFT( TAIL_FFT_ORDER )
+{
+    for ( int i = 0; i < amountOfChannels; ++i ) {
+        auto* channel = channels.add( new Channel());
+
+        channel->headFrame.resize  ( HEAD_PARTITION_SIZE * 2, 0.f );
+        channel->headSpectra.resize( NUM_HEAD_PARTITIONS * HEAD_BINS * 2, 0.f );
+        channel->headOutput.resize ( HEAD_PARTITION_SIZE, 0.f );
+        channel->tailInput.resize  ( TAIL_PARTITION_SIZE * NUM_SLOTS, 0.f );
+        channel->tailOutput.resize ( TAIL_PARTITION_SIZE * NUM_SLOTS, 0.f );
+        channel->heldMagnitudes.resize  ( TAIL_BINS, 0.f );
+        channel->synthesisOverlap.resize( TAIL_PARTITION_SIZE, 0.f );
+        channel->phaseRandom.setSeed( i + 1 ); // deterministic and decorrelated between channels
+
+        for ( auto& slotBlock : channel->slotBlocks ) {
+            slotBlock.store( -1 );
+        }
+    }
+    headTransform.resize( HEAD_PARTITION_SIZE * 4, 0.f );
+    headSum.resize      ( HEAD_BINS * 2, 0.f );
+    tailTransform.resize( TAIL_PARTITION_SIZE * 4, 0.f );
+    tailSum.resize      ( TAIL_BINS * 2, 0.f );
+
+    synthesisWindow.resize( TAIL_PARTITION_SIZE * 2 );
+
+    for ( size_t i = 0; i < synthesisWindow.size(); ++i ) {
+        synthesisWindow[ i ] = std::sin( juce::MathConstants<float>::pi * ( static_cast<float>( i ) + 0.5f ) / static_cast<float>( synthesisWindow.size()));
+    }
+
+    startThread( juce::Thread::Priority::high );
+}
+
+ConvolutionReverb::~ConvolutionReverb()
+{
+    stopThread( 1000 );
+}
+
+/* public methods */
+
+std::unique_ptr<ConvolutionReverb::ImpulseResponse> ConvolutionReverb::createImpulseResponse( const juce::File& file )
+{
+    // the file is mapped into memory rather than streamed, so even long impulse responses are read in one pass
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader( formatManager.createMemoryMappedReader( file ));
+
+    if ( reader == nullptr || !reader->mapEntireFile()) {
+        return nullptr;
+    }
+
+    auto length = std::min( reader->lengthInSamples, static_cast<juce::int64>( MAX_DURATION * reader->sampleRate ));
+    int numChannels = std::min( static_cast<int>( reader->numChannels ), ImpulseResponse::MAX_CHANNELS );
+
+    if ( length <= 0 || numChannels <= 0 ) {
+        return nullptr;
+    }
+
+    juce::AudioBuffer<float> buffer( numChannels, static_cast<int>( length ));
+    reader->read( &buffer, 0, static_cast<int>( length ), 0, true, numChannels > 1 );
+
+    return createImpulseResponse( buffer, reader->sampleRate );
+}
+
+std::unique_ptr<ConvolutionReverb::ImpulseResponse> ConvolutionReverb::createImpulseResponse( const juce::AudioBuffer<float>& buffer, double bufferSampleRate )
+{
+    int numChannels = std::min( buffer.getNumChannels(), ImpulseResponse::MAX_CHANNELS );
+    double ratio    = bufferSampleRate / _sampleRate;
+    int length      = std::min( static_cast<int>( buffer.getNumSamples() / ratio ), static_cast<int>( MAX_DURATION * _sampleRate ));
+
+    // resample to the processing rate and normalize the energy (so the reverb is about as loud as its input)
+
+    juce::AudioBuffer<float> resampled( numChannels, length );
+    float energy = 0.f;
+
+    for ( int channel = 0; channel < numChannels; ++channel ) {
+        if ( juce::approximatelyEqual( ratio, 1.0 )) {
+            resampled.copyFrom( channel, 0, buffer, channel, 0, length );
+        } else {
+            juce::LagrangeInterpolator interpolator;
+            interpolator.process( ratio, buffer.getReadPointer( channel ), resampled.getWritePointer( channel ), length );
+        }
+        const float* samples = resampled.getReadPointer( channel );
+
+        for ( int i = 0; i < length; ++i ) {
+            energy += samples[ i ] * samples[ i ] / static_cast<float>( numChannels );
+        }
+    }
+
+    if ( energy > 0.f ) {
+        resampled.applyGain( 1.f / std::sqrt( energy ));
+    }
+
+    // the head is partitioned for the audio thread, the remainder in (longer) partitions for the background thread
+
+    auto prepared = std::make_unique<ImpulseResponse>();
+
+    prepared->numChannels       = numChannels;
+    prepared->numTailPartitions = std::max( 0, ( length - HEAD_LENGTH + TAIL_PARTITION_SIZE - 1 ) / TAIL_PARTITION_SIZE );
+
+    for ( int channel = 0; channel < numChannels; ++channel ) {
+        const float* samples = resampled.getReadPointer( channel );
+
+        prepared->head[ channel ].resize( NUM_HEAD_PARTITIONS * HEAD_BINS * 2 );
+        prepared->tail[ channel ].resize( static_cast<size_t>( prepared->numTailPartitions * TAIL_BINS * 2 ));
+
+        transformPartitions( samples, std::min( length, HEAD_LENGTH ), HEAD_PARTITION_SIZE, NUM_HEAD_PARTITIONS,
+                             headFFT, prepared->head[ channel ].data());
+
+        if ( prepared->numTailPartitions > 0 ) {
+            transformPartitions( samples + HEAD_LENGTH, length - HEAD_LENGTH, TAIL_PARTITION_SIZE, prepared->numTailPartitions,
+                                 tailFFT, prepared->tail[ channel ].data());
+        }
+    }
+    return prepared;
+}
+
+std::unique_ptr<ConvolutionReverb::ImpulseResponse> ConvolutionReverb::createDefaultImpulseResponse( float decayTime )
+{
+    int length = static_cast<int>( std::min( static_cast<double>( decayTime ), MAX_DURATION ) * _sampleRate );
+
+    juce::AudioBuffer<float> buffer( ImpulseResponse::MAX_CHANNELS, length );
+    juce::Random random( 1 ); // deterministic, so the default reverb sounds alike on each instantiation
+
+    for ( int channel = 0; channel < ImpulseResponse::MAX_CHANNELS; ++channel ) {
+        float* samples = buffer.getWritePointer( channel );
+
+        for ( int i = 0; i < length; ++i ) {
+            // decays by 60 dB over the decay time
+            float envelope = std::exp( -6.9078f * static_cast<float>( i ) / ( decayTime * static_cast<float>( _sampleRate )));
+            samples[ i ] = ( random.nextFloat() * 2.f - 1.f ) * envelope;
+        }
+    }
+    return createImpulseResponse( buffer, _sampleRate );
+}
+
+void ConvolutionReverb::setImpulseResponse( std::unique_ptr<ImpulseResponse> newImpulseResponse )
+{
+    const juce::ScopedLock lock( tailLock ); // the background thread isn't rendering while swapping
+
+    impulseResponse = std::move( newImpulseResponse );
+
+    int numTailPartitions = impulseResponse != nullptr ? impulseResponse->numTailPartitions : 0;
+
+    for ( auto* channel : channels ) {
+        channel->tailSpectra.assign( static_cast<size_t>( numTailPartitions * TAIL_BINS * 2 ), 0.f );
+        channel->tailSpectrum = 0;
+    }
+    reset();
+}
+
+void ConvolutionReverb::apply( int channelIndex, float* channelData, int bufferSize )
+{
+    if ( !isActive() || channelIndex >= channels.size() || impulseResponse == nullptr ) {
+        return;
+    }
+
+    auto& channel = *channels[ channelIndex ];
+
+    if ( !channel.isEngaged ) {
+        resetChannel( channel );
+    }
+
+    // while frozen, the input is no longer received: the head decays and the background thread sustains the tail
+
+    bool hold = _mode == FREEZE_MODE;
+
+    for ( int offset = 0; offset < bufferSize; ) {
+        int headPosition = channel.position % HEAD_PARTITION_SIZE;
+        int frames = std::min( HEAD_PARTITION_SIZE - headPosition, bufferSize - offset );
+
+        // the tail rendered for block n is played back from the start of block n + 2 (offset by the head latency)
+
+        int tailPosition = channel.position - HEAD_PARTITION_SIZE;
+        int tailBlock    = channel.currentBlock - 2;
+
+        if ( tailPosition < 0 ) {
+            tailPosition += TAIL_PARTITION_SIZE;
+            --tailBlock;
+        }
+        int slot = ( tailBlock + NUM_SLOTS ) % NUM_SLOTS;
+
+        // when the background thread didn't deliver the block in time, the tail is omitted (unless rendering
+        // offline, blocks received after the channel was reset are then waited for, without notifying the thread
+        // as that requires a lock)
+
+        if ( _isNonRealtime && tailBlock >= channel.resetBlock.load()) {
+            while ( channel.slotBlocks[ slot ].load() != tailBlock ) {
+                juce::Thread::yield();
+            }
+        }
+        const float* tail = channel.slotBlocks[ slot ].load() == tailBlock ? channel.tailOutput.data() + slot * TAIL_PARTITION_SIZE + tailPosition : nullptr;
+        const float* head = channel.headOutput.data() + headPosition;
+
+        float* samples  = channelData + offset;
+        float* input    = channel.headFrame.data() + HEAD_PARTITION_SIZE + headPosition;
+        float* received = channel.tailInput.data() + ( channel.currentBlock % NUM_SLOTS ) * TAIL_PARTITION_SIZE + channel.position;
+
+        for ( int i = 0; i < frames; ++i ) {
+            float inputSample    = samples[ i ];
+            float receivedSample = hold ? 0.f : inputSample;
+            float wet = head[ i ] + ( tail != nullptr ? tail[ i ] : 0.f );
+
+            input[ i ]    = receivedSample;
+            received[ i ] = receivedSample;
+            samples[ i ]  = wet * _wet + inputSample * _dry;
+
+            channel.wetEnergy += wet * wet;
+        }
+        channel.position += frames;
+        offset += frames;
+
+        if ( channel.position % HEAD_PARTITION_SIZE == 0 ) {
+            channel.heldPartitions = hold ? channel.heldPartitions + 1 : 0;
+            processHead( channel, channelIndex );
+        }
+
+        if ( channel.position == TAIL_PARTITION_SIZE ) {
+            // hand the received block to the background thread
+
+            channel.inputHeld[ channel.currentBlock % NUM_SLOTS ] = hold;
+            channel.wetLevels[ channel.currentBlock % NUM_SLOTS ] = std::sqrt( channel.wetEnergy / static_cast<float>( TAIL_PARTITION_SIZE ));
+            channel.wetEnergy = 0.f;
+            channel.submittedBlock.store( channel.currentBlock );
+
+            ++channel.currentBlock;
+            channel.position = 0;
+        }
+    }
+
+    if ( _mode == FREEZE_PENDING && channelIndex == channels.size() - 1 ) {
+        _freezeDelay -= bufferSize;
+        if ( _freezeDelay <= 0 ) {
+            _mode = FREEZE_MODE; // the received input is now held
+        }
+    }
+}
+
+void ConvolutionReverb::reset()
+{
+    for ( auto* channel : channels ) {
+        channel->isEngaged = false;
+    }
+
+    // the cleared channels have nothing to sustain, receive input again before freezing
+
+    if ( _mode == FREEZE_MODE ) {
+        scheduleFreeze();
+    }
+}
+
+void ConvolutionReverb::setWet( float value )
+{
+    _wet = value;
+
+    if ( !isActive()) {
+        reset();
+    }
+}
+
+float ConvolutionReverb::getWet()
+{
+    return _wet;
+}
+
+void ConvolutionReverb::setDry( float value )
+{
+    _dry = value;
+}
+
+float ConvolutionReverb::getDry()
+{
+    return _dry;
+}
+
+int ConvolutionReverb::getMode()
+{
+    return _mode;
+}
+
+void ConvolutionReverb::setMode( int value )
+{
+    // as with Reverb, freezing is delayed until the reverb has received enough input to sustain
+
+    if ( _mode == FREEZE_PENDING && value == FREEZE_MODE ) {
+        return;
+    }
+
+    if ( _mode == INITIAL_MODE && value == FREEZE_MODE ) {
+        scheduleFreeze();
+    } else {
+        _mode = value;
+    }
+}
+
+void ConvolutionReverb::setNonRealtime( bool value )
+{
+    _isNonRealtime = value;
+}
+
+/* private methods */
+
+void ConvolutionReverb::run()
+{
+    while ( !threadShouldExit()) {
+        {
+            const juce::ScopedLock lock( tailLock );
+
+            for ( int i = 0; i < channels.size(); ++i ) {
+                processTail( *channels[ i ], i );
+            }
+        }
+        wait( INTERVAL_MS );
+    }
+}
+
+void ConvolutionReverb::resetChannel( Channel& channel )
+{
+    std::fill( channel.headFrame.begin(),   channel.headFrame.end(),   0.f );
+    std::fill( channel.headSpectra.begin(), channel.headSpectra.end(), 0.f );
+    std::fill( channel.headOutput.begin(),  channel.headOutput.end(),  0.f );
+    std::fill( channel.tailInput.begin(),   channel.tailInput.end(),   0.f );
+
+    // skip the block numbers of all slots so previously rendered tail blocks are never played back
+
+    channel.currentBlock += NUM_SLOTS + ( channel.position > 0 ? 1 : 0 );
+    channel.position  = 0;
+    channel.heldPartitions = 0;
+    channel.wetEnergy = 0.f;
+    channel.isEngaged = true;
+    channel.resetBlock.store( channel.currentBlock );
+}
+
+void ConvolutionReverb::scheduleFreeze()
+{
+    // the input is received for at least a full tail block, so the tail has input to sustain once frozen
+
+    _mode = FREEZE_PENDING;
+    _freezeDelay = std::max( Calc::secondsToBuffer( Parameters::Config::REVERB_FREEZE_TIMEOUT, static_cast<float>( _sampleRate )), TAIL_PARTITION_SIZE );
+}
+
+void ConvolutionReverb::processHead( Channel& channel, int channelIndex )
+{
+    // once frozen for longer than the head spans, its delay line (and thus its output) only holds silence
+
+    if ( channel.heldPartitions > NUM_HEAD_PARTITIONS + 1 ) {
+        return;
+    }
+
+    // transform the last two partitions of the input and add the spectrum to the delay line
+
+    std::copy( channel.headFrame.begin(), channel.headFrame.end(), headTransform.begin());
+    headFFT.performRealOnlyForwardTransform( headTransform.data(), true );
+
+    channel.headSpectrum = ( channel.headSpectrum + 1 ) % NUM_HEAD_PARTITIONS;
+
+    float* spectrum = channel.headSpectra.data() + channel.headSpectrum * HEAD_BINS * 2;
+
+    for ( int bin = 0; bin < HEAD_BINS; ++bin ) {
+        spectrum[ bin ]             = headTransform[ static_cast<size_t>( bin * 2 )];
+        spectrum[ HEAD_BINS + bin ] = headTransform[ static_cast<size_t>( bin * 2 + 1 )];
+    }
+    auto& filter = impulseResponse->head[ channelIndex % impulseResponse->numChannels ];
+
+    multiplyAccumulate( channel.headSpectra.data(), channel.headSpectrum, filter.data(), NUM_HEAD_PARTITIONS, HEAD_BINS, headSum.data());
+
+    for ( int bin = 0; bin < HEAD_BINS; ++bin ) {
+        headTransform[ static_cast<size_t>( bin * 2 )]     = headSum[ static_cast<size_t>( bin )];
+        headTransform[ static_cast<size_t>( bin * 2 + 1 )] = headSum[ static_cast<size_t>( HEAD_BINS + bin )];
+    }
+    headFFT.performRealOnlyInverseTransform( headTransform.data());
+
+    // the first half of the frame is circularly aliased, the second half is the output for the partition
+
+    std::copy_n( headTransform.begin() + HEAD_PARTITION_SIZE, HEAD_PARTITION_SIZE, channel.headOutput.begin());
+    std::copy_n( channel.headFrame.begin() + HEAD_PARTITION_SIZE, HEAD_PARTITION_SIZE, channel.headFrame.begin());
+}
+
+void ConvolutionReverb::processTail( Channel& channel, int channelIndex )
+{
+    int submittedBlock = channel.submittedBlock.load();
+
+    while ( channel.renderedBlock < submittedBlock ) {
+        int block = channel.renderedBlock + 1;
+
+        // the audio thread reuses the slots of blocks older than the previous block, when the background
+        // thread has fallen behind (or the channel was reset) continue at the oldest block still available
+
+        if ( block < submittedBlock - 1 ) {
+            block = std::max( submittedBlock - 1, channel.resetBlock.load());
+        }
+        renderTailBlock( channel, channelIndex, block );
+        channel.renderedBlock = block;
+    }
+}
+
+void ConvolutionReverb::renderTailBlock( Channel& channel, int channelIndex, int block )
+{
+    int slot  = block % NUM_SLOTS;
+    int numPartitions = impulseResponse != nullptr ? impulseResponse->numTailPartitions : 0;
+    float* output = channel.tailOutput.data() + slot * TAIL_PARTITION_SIZE;
+
+    if ( numPartitions == 0 ) {
+        std::fill_n( output, TAIL_PARTITION_SIZE, 0.f );
+        channel.slotBlocks[ slot ].store( block );
+        return;
+    }
+
+    int resetBlock = channel.resetBlock.load();
+
+    if ( block >= resetBlock && channel.renderedBlock < resetBlock ) {
+        std::fill( channel.tailSpectra.begin(), channel.tailSpectra.end(), 0.f );
+        channel.tailSpectrum = 0;
+        channel.isResynthesising = false;
+    }
+
+    // read the received input (and the level played back during the previous block) from the slots first
+
+    int previousSlot    = ( block + NUM_SLOTS - 1 ) % NUM_SLOTS;
+    bool isHeld         = channel.inputHeld[ slot ];
+    float previousLevel = channel.wetLevels[ previousSlot ];
+
+    if ( !isHeld ) {
+        std::copy_n( channel.tailInput.begin() + previousSlot * TAIL_PARTITION_SIZE, TAIL_PARTITION_SIZE, tailTransform.begin());
+        std::copy_n( channel.tailInput.begin() + slot * TAIL_PARTITION_SIZE, TAIL_PARTITION_SIZE, tailTransform.begin() + TAIL_PARTITION_SIZE );
+    }
+
+    // the audio thread starts writing into the slot of the previous block once block + NUM_SLOTS - 2 was submitted.
+    // When the background thread has fallen that far behind, the slots may have been reused while reading them:
+    // the block is dropped (it is too late to be played back anyway, processTail() continues at the oldest block)
+
+    std::atomic_thread_fence( std::memory_order_acquire );
+
+    if ( channel.submittedBlock.load() >= block + NUM_SLOTS - 2 ) {
+        return;
+    }
+
+    if ( isHeld && channel.isResynthesising ) {
+        std::fill_n( output, TAIL_PARTITION_SIZE, 0.f );
+        resynthesiseTail( channel, output );
+        channel.slotBlocks[ slot ].store( block );
+        return;
+    }
+
+    // advance the delay line with the spectrum of the received block (silence when the block was held)
+
+    channel.tailSpectrum = ( channel.tailSpectrum + 1 ) % numPartitions;
+
+    float* spectrum = channel.tailSpectra.data() + channel.tailSpectrum * TAIL_BINS * 2;
+
+    if ( isHeld ) {
+        std::fill_n( spectrum, TAIL_BINS * 2, 0.f );
+    } else {
+        tailFFT.performRealOnlyForwardTransform( tailTransform.data(), true );
+
+        for ( int bin = 0; bin < TAIL_BINS; ++bin ) {
+            spectrum[ bin ]             = tailTransform[ static_cast<size_t>( bin * 2 )];
+            spectrum[ TAIL_BINS + bin ] = tailTransform[ static_cast<size_t>( bin * 2 + 1 )];
+        }
+        channel.isResynthesising = false;
+    }
+    auto& filter = impulseResponse->tail[ channelIndex % impulseResponse->numChannels ];
+
+    multiplyAccumulate( channel.tailSpectra.data(), channel.tailSpectrum, filter.data(), numPartitions, TAIL_BINS, tailSum.data());
+
+    for ( int bin = 0; bin < TAIL_BINS; ++bin ) {
+        tailTransform[ static_cast<size_t>( bin * 2 )]     = tailSum[ static_cast<size_t>( bin )];
+        tailTransform[ static_cast<size_t>( bin * 2 + 1 )] = tailSum[ static_cast<size_t>( TAIL_BINS + bin )];
+    }
+    tailFFT.performRealOnlyInverseTransform( tailTransform.data());
+
+    std::copy_n( tailTransform.begin() + TAIL_PARTITION_SIZE, TAIL_PARTITION_SIZE, output );
+
+    if ( isHeld ) {
+        // the first held block: the tail of the received input decays (faded out over the block) while the
+        // resynthesis of its spectrum fades in, the windows of both are power complementary
+
+        captureTail( channel, output, block > resetBlock ? previousLevel : 0.f );
+
+        for ( int i = 0; i < TAIL_PARTITION_SIZE; ++i ) {
+            output[ i ] *= synthesisWindow[ static_cast<size_t>( TAIL_PARTITION_SIZE + i )];
+        }
+        resynthesiseTail( channel, output );
+    }
+    channel.slotBlocks[ slot ].store( block ); // publishes the rendered block to the audio thread
+}
+
+void ConvolutionReverb::captureTail( Channel& channel, const float* decay, float level )
+{
+    // the spectrum of the decaying block holds the timbre of the reverb at the moment of freezing
+
+    std::fill( tailTransform.begin(), tailTransform.end(), 0.f );
+    std::copy_n( decay, TAIL_PARTITION_SIZE, tailTransform.begin());
+
+    tailFFT.performRealOnlyForwardTransform( tailTransform.data(), true );
+
+    float energy = 0.f;
+
+    for ( int bin = 0; bin < TAIL_BINS; ++bin ) {
+        float real      = tailTransform[ static_cast<size_t>( bin * 2 )];
+        float imaginary = tailTransform[ static_cast<size_t>( bin * 2 + 1 )];
+        float power     = real * real + imaginary * imaginary;
+
+        channel.heldMagnitudes[ static_cast<size_t>( bin )] = std::sqrt( power );
+        energy += bin == 0 || bin == TAIL_BINS - 1 ? power : power * 2.f; // (the mirrored bins of the full spectrum)
+    }
+
+    // scale the magnitudes so the resynthesised frames (of which the overlapping windows sum to
+    // constant power) sustain the level of the wet signal that was played back before freezing.
+    // Without a level (e.g. when frozen right away) the level of the decaying block itself is sustained
+
+    constexpr float frameSize = static_cast<float>( TAIL_PARTITION_SIZE * 2 );
+    float framePower  = energy / ( frameSize * frameSize );
+    float targetPower = level > 0.f ? level * level : framePower * 2.f; // the block spans half of the frame
+
+    if ( framePower > 0.f ) {
+        float gain = std::sqrt( targetPower / framePower );
+
+        for ( auto& magnitude : channel.heldMagnitudes ) {
+            magnitude *= gain;
+        }
+    }
+    std::fill( channel.synthesisOverlap.begin(), channel.synthesisOverlap.end(), 0.f );
+    channel.isResynthesising = true;
+}
+
+void ConvolutionReverb::resynthesiseTail( Channel& channel, float* output )
+{
+    // a frame of the held magnitudes with random phases, windowed and overlapped by half its length
+    // (so each output block adds the first half of a new frame to the second half of the previous frame)
+
+    for ( int bin = 0; bin < TAIL_BINS; ++bin ) {
+        float magnitude = channel.heldMagnitudes[ static_cast<size_t>( bin )];
+        float phase     = channel.phaseRandom.nextFloat() * juce::MathConstants<float>::twoPi;
+
+        tailTransform[ static_cast<size_t>( bin * 2 )]     = magnitude * std::cos( phase );
+        tailTransform[ static_cast<size_t>( bin * 2 + 1 )] = magnitude * std::sin( phase );
+    }
+    tailFFT.performRealOnlyInverseTransform( tailTransform.data());
+
+    for ( int i = 0; i < TAIL_PARTITION_SIZE; ++i ) {
+        auto index = static_cast<size_t>( i );
+
+        output[ i ] += channel.synthesisOverlap[ index ] + tailTransform[ index ] * synthesisWindow[ index ];
+        channel.synthesisOverlap[ index ] = tailTransform[ index + TAIL_PARTITION_SIZE ] * synthesisWindow[ index + TAIL_PARTITION_SIZE ];
+    }
+}
+
+void ConvolutionReverb::transformPartitions( const float* samples, int length, int partitionSize, int amountOfPartitions,
+                                             const juce::dsp::FFT& fft, float* spectra )
+{
+    int bins = partitionSize + 1;
+    std::vector<float> partition( static_cast<size_t>( partitionSize * 4 ));
+
+    for ( int index = 0; index < amountOfPartitions; ++index ) {
+        // each partition is zero padded to twice its size
+
+        int start = index * partitionSize;
+
+        std::fill( partition.begin(), partition.end(), 0.f );
+
+        if ( start < length ) {
+            std::copy_n( samples + start, std::min( partitionSize, length - start ), partition.begin());
+        }
+        fft.performRealOnlyForwardTransform( partition.data(), true );
+
+        float* real      = spectra + index * bins * 2;
+        float* imaginary = real + bins;
+
+        for ( int bin = 0; bin < bins; ++bin ) {
+            real[ bin ]      = partition[ static_cast<size_t>( bin * 2 )];
+            imaginary[ bin ] = partition[ static_cast<size_t>( bin * 2 + 1 )];
+        }
+    }
+}
+
+void ConvolutionReverb::multiplyAccumulate( const float* spectra, int latestSpectrum, const float* filter,
+                                            int amountOfPartitions, int bins, float* sum )
+{
+    // multiplies the delayed input spectra with the corresponding partitions of the filter
+
+    float* sumReal      = sum;
+    float* sumImaginary = sum + bins;
+
+    std::fill_n( sum, bins * 2, 0.f );
+
+    for ( int index = 0; index < amountOfPartitions; ++index ) {
+        int delayed = ( latestSpectrum - index + amountOfPartitions ) % amountOfPartitions;
+
+        const float* inputReal       = spectra + delayed * bins * 2;
+        const float* inputImaginary  = inputReal + bins;
+        const float* filterReal      = filter + index * bins * 2;
+        const float* filterImaginary = filterReal + bins;
+
+        for ( int bin = 0; bin < bins; ++bin ) {
+            sumReal[ bin ]      += inputReal[ bin ] * filterReal[ bin ] - inputImaginary[ bin ] * filterImaginary[ bin ];
+            sumImaginary[ bin ] += inputReal[ bin ] * filterImaginary[ bin ] + inputImaginary[ bin ] * filterReal[ bin ];
+        }
+    }
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_dsp/juce_dsp.h>
+#include "../../Parameters.h"
+#include <atomic>
+#include <vector>
+
+/**
+ * Convolution reverb using non-uniformly partitioned overlap-save convolution. The impulse response is divided into
+ * a head, convolved on the audio thread in short uniform partitions, and a tail, convolved in long partitions by a
+ * background thread. The head spans the time the background thread has to deliver the tail, so the tail (which holds
+ * the vast majority of a multi-second impulse response) never adds to the cost of the audio thread.
+ *
+ * The audio thread hands each complete block of input to the background thread and reads back the convolved blocks
+ * through lock-free slots (see Channel). Freezing stops receiving input: the head decays while the background thread
+ * captures the magnitude spectrum of the decaying tail and keeps resynthesising it (with random phases, in overlapping
+ * windowed frames), sustaining the tail indefinitely without repeating.
+ *
+ * The wet signal is delayed by the head partition size. Offers the same mix and mode controls as Reverb.
+ */
+class ConvolutionReverb : private juce::Thread
+{
+    public:
+        static constexpr int HEAD_PARTITION_SIZE = 256;
+        static constexpr int TAIL_PARTITION_SIZE = 4096;
+        static constexpr double MAX_DURATION = 10.0; // in seconds, longer impulse responses are truncated
+
+        static const int INITIAL_MODE   = 0;
+        static const int FREEZE_MODE    = 1;
+        static const int FREEZE_PENDING = 2;
+
+        // a prepared impulse response, partitioned and transformed (created by a non-audio thread)
+
+        struct ImpulseResponse
+        {
+            static constexpr int MAX_CHANNELS = 2;
+
+            int numChannels       = 0;
+            int numTailPartitions = 0;
+
+            std::vector<float> head[ MAX_CHANNELS ]; // NUM_HEAD_PARTITIONS spectra (real and imaginary parts)
+            std::vector<float> tail[ MAX_CHANNELS ]; // numTailPartitions spectra (real and imaginary parts)
+        };
+
+        ConvolutionReverb( double sampleRate, int amountOfChannels );
+        ~ConvolutionReverb() override;
+
+        // prepares an impulse response read from given audio file (memory mapped) or from given buffer, returns
+        // nullptr when the file could not be read. Can be called from any non-audio thread while rendering
+
+        std::unique_ptr<ImpulseResponse> createImpulseResponse( const juce::File& file );
+        std::unique_ptr<ImpulseResponse> createImpulseResponse( const juce::AudioBuffer<float>& buffer, double bufferSampleRate );
+
+        // a stereo, exponentially decaying noise burst of given decay time (RT60, in seconds)
+        std::unique_ptr<ImpulseResponse> createDefaultImpulseResponse( float decayTime );
+
+        // applies a prepared impulse response. Not to be called during rendering (e.g. suspend processing first)
+
+        void setImpulseResponse( std::unique_ptr<ImpulseResponse> impulseResponse );
+
+        inline bool isActive() {
+            return _wet > 0.f;
+        }
+
+        void apply( int channel, float* channelData, int bufferSize );
+
+        // clears the convolution state (of all channels) once rendered again
+        void reset();
+
+        void setWet( float value );
+        float getWet();
+        void setDry( float value );
+        float getDry();
+        int getMode();
+        void setMode( int value );
+
+        // when rendering offline, tail blocks that weren't delivered in time are waited for rather than omitted
+        // (so the output doesn't depend on the timing of the background thread)
+
+        void setNonRealtime( bool value );
+
+    private:
+        static const int HEAD_FFT_ORDER = 9;  // transforms two head partitions
+        static const int TAIL_FFT_ORDER = 13; // transforms two tail partitions
+        static const int HEAD_BINS      = HEAD_PARTITION_SIZE + 1;
+        static const int TAIL_BINS      = TAIL_PARTITION_SIZE + 1;
+
+        // the tail for a block of input is rendered by the background thread while the next block is received,
+        // and is required once that block has been received in full: the head spans the first two tail partitions
+
+        static constexpr int HEAD_LENGTH         = TAIL_PARTITION_SIZE * 2;
+        static constexpr int NUM_HEAD_PARTITIONS = HEAD_LENGTH / HEAD_PARTITION_SIZE;
+
+        static const int NUM_SLOTS   = 4; // tail blocks in flight (being received, rendered and played back)
+        static const int INTERVAL_MS = 2; // at which the background thread checks for received blocks
+
+        // the convolution state of a single channel. The tail blocks are exchanged in slots: the audio thread
+        // writes the input of block n into slot n % NUM_SLOTS and publishes it through submittedBlock, the background
+        // thread renders the tail into the output slot of the same index and publishes it through slotBlocks
+
+        struct Channel
+        {
+            // managed by the audio thread
+
+            bool isEngaged   = false; // whether the reverb was active in the previous block
+            int position     = 0;     // within the current tail block
+            int currentBlock = 0;
+            int headSpectrum = 0;     // index of the most recent spectrum within the head delay line
+            int heldPartitions = 0;   // amount of successive head partitions received while frozen
+
+            std::vector<float> headFrame;   // previous and current head partition of the input
+            std::vector<float> headSpectra; // frequency domain delay line of the head
+            std::vector<float> headOutput;  // last rendered head partition
+            std::vector<float> tailInput;   // NUM_SLOTS tail blocks of input
+            bool inputHeld[ NUM_SLOTS ] = {}; // whether the block was received while frozen
+            float wetLevels[ NUM_SLOTS ] = {}; // RMS of the wet signal played back during the block
+            float wetEnergy = 0.f;             // of the wet signal played back during the current block
+
+            // managed by the background thread
+
+            int renderedBlock = -1;
+            int tailSpectrum  = 0;
+            std::vector<float> tailSpectra; // frequency domain delay line of the tail
+            std::vector<float> tailOutput;  // NUM_SLOTS rendered tail blocks
+
+            bool isResynthesising = false;       // whether the tail is frozen (see resynthesiseTail())
+            std::vector<float> heldMagnitudes;   // magnitude spectrum of the tail captured when freezing
+            std::vector<float> synthesisOverlap; // second half of the previous resynthesised frame
+            juce::Random phaseRandom;            // phases of the resynthesised tail (seeded per channel)
+
+            std::atomic<int> submittedBlock { -1 };
+            std::atomic<int> resetBlock { 0 }; // the first block after the audio thread was reset
+            std::atomic<int> slotBlocks[ NUM_SLOTS ];
+        };
+
+        double _sampleRate;
+        float _wet = 0.f;
+        float _dry = 1.f;
+        int _mode  = INITIAL_MODE;
+        int _freezeDelay = 0;
+        bool _isNonRealtime = false;
+
+        juce::dsp::FFT headFFT;
+        juce::dsp::FFT tailFFT;
+
+        std::unique_ptr<ImpulseResponse> impulseResponse;
+        juce::OwnedArray<Channel> channels;
+        juce::CriticalSection tailLock; // held by the background thread while rendering, never acquired on the audio thread
+
+        // shared by all channels as these are rendered in succession (separately for both threads)
+
+        std::vector<float> headTransform;
+        std::vector<float> headSum;
+        std::vector<float> tailTransform;
+        std::vector<float> tailSum;
+
+        std::vector<float> synthesisWindow; // sine window, the overlapping frames sum to constant power
+
+        void run() override;
+
+        void resetChannel( Channel& channel );
+        void scheduleFreeze();
+        void processHead( Channel& channel, int channelIndex );
+        void processTail( Channel& channel, int channelIndex );
+        void renderTailBlock( Channel& channel, int channelIndex, int block );
+
+        // while frozen, the tail is resynthesised from the magnitudes captured from the first held block
+        // (scaled to the level of the wet signal played back before freezing)
+
+        void captureTail( Channel& channel, const float* decay, float level );
+        void resynthesiseTail( Channel& channel, float* output );
+
+        void transformPartitions( const float* samples, int length, int partitionSize, int amountOfPartitions, const juce::dsp::FFT& fft, float* spectra );
+
+        static void multiplyAccumulate( const float* spectra, int latestSpectrum, const float* filter,
+                                        int amountOfPartitions, int bins, float* sum );
+
+        JUCE_DECLARE_NON_COPYABLE( ConvolutionReverb )
+};
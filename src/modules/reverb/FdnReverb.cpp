@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "FdnReverb.h"
+#include "../../utils/Calc.h"
+
+FdnReverb::FdnReverb( double sampleRate, float decayTime, float damp ) :
+    _sampleRate( sampleRate ),
+    _decayTime( decayTime ),
+    _damp( damp )
+{
+    shortestLine = MAX_BLOCK;
+
+    for ( int line = 0; line < NUM_LINES; ++line ) {
+        // tune the lines to the host environments sample rate
+        int size = static_cast<int>(( static_cast<double>( Parameters::Config::FDN_TUNINGS[ line ]) / 44100.0 ) * sampleRate );
+
+        lines[ line ].resize( static_cast<size_t>( std::max( size, 1 )), 0.f );
+        shortestLine = std::min( shortestLine, static_cast<int>( lines[ line ].size()));
+    }
+
+    update();
+    clear();
+}
+
+/* public methods */
+
+void FdnReverb::apply( int channel, float* channelData, int bufferSize )
+{
+    if ( !isActive()) {
+        return;
+    }
+
+    if ( !isEngaged ) {
+        clear();
+    }
+    jassert( bufferSize <= PRE_DELAY );
+
+    float* input        = inputRing [ channel % MAX_CHANNELS ];
+    const float* output = outputRing[ channel % MAX_CHANNELS ];
+
+    // (multiple channels sharing the same vectors are summed)
+
+    for ( int i = 0, index = position, delayed = ( position - PRE_DELAY + RING_SIZE ) % RING_SIZE; i < bufferSize; ++i ) {
+        input[ index ] += channelData[ i ];
+        channelData[ i ] = output[ delayed ] * _wet + channelData[ i ] * _dry;
+
+        if ( ++index == RING_SIZE ) {
+            index = 0;
+        }
+        if ( ++delayed == RING_SIZE ) {
+            delayed = 0;
+        }
+    }
+}
+
+void FdnReverb::advance( int bufferSize )
+{
+    if ( !isActive()) {
+        return;
+    }
+
+    if ( !isEngaged ) {
+        clear();
+    }
+
+    for ( int offset = 0; offset < bufferSize; ) {
+        int frameCount = std::min({ bufferSize - offset, shortestLine, RING_SIZE - position });
+
+        ( this->*variant )( position, frameCount );
+
+        position = ( position + frameCount ) % RING_SIZE;
+        offset  += frameCount;
+    }
+
+    if ( _mode == FREEZE_PENDING ) {
+        _freezeDelay -= bufferSize;
+        if ( _freezeDelay <= 0 ) {
+            _mode = FREEZE_MODE;
+            update(); // the network now holds enough reverberated audio to sustain
+        }
+    }
+}
+
+void FdnReverb::reset()
+{
+    isEngaged = false;
+}
+
+float FdnReverb::getDecayTime()
+{
+    return _decayTime;
+}
+
+void FdnReverb::setDecayTime( float value )
+{
+    _decayTime = value;
+    update();
+}
+
+float FdnReverb::getDamp()
+{
+    return _damp;
+}
+
+void FdnReverb::setDamp( float value )
+{
+    _damp = value;
+}
+
+float FdnReverb::getWet()
+{
+    return _wet;
+}
+
+void FdnReverb::setWet( float value )
+{
+    _wet = value;
+
+    if ( !isActive()) {
+        reset();
+    }
+}
+
+float FdnReverb::getDry()
+{
+    return _dry;
+}
+
+void FdnReverb::setDry( float value )
+{
+    _dry = value;
+}
+
+int FdnReverb::getMode()
+{
+    return _mode;
+}
+
+void FdnReverb::setMode( int value )
+{
+    // as with Reverb, freezing is delayed until the network has received enough input to sustain
+
+    if ( _mode == FREEZE_PENDING && value == FREEZE_MODE ) {
+        return;
+    }
+
+    if ( _mode == INITIAL_MODE && value == FREEZE_MODE ) {
+        _mode = FREEZE_PENDING;
+        _freezeDelay = Calc::secondsToBuffer( Parameters::Config::REVERB_FREEZE_TIMEOUT, static_cast<float>( _sampleRate ));
+    } else {
+        _mode = value;
+        update();
+    }
+}
+
+void FdnReverb::setSimdLevel( int level )
+{
+    variant = Simd::select<Variant>( level, &FdnReverb::renderBaseline, &FdnReverb::renderAvx2, &FdnReverb::renderAvx512 );
+}
+
+/* private methods */
+
+void FdnReverb::update()
+{
+    // the gain of each line attenuates it by 60 dB over the decay time (relative to its length), unless frozen
+    // in which case the network is lossless. The normalization of the Hadamard matrix is applied here as well
+
+    float scale = 1.f / std::sqrt( static_cast<float>( NUM_LINES ));
+
+    for ( int line = 0; line < NUM_LINES; ++line ) {
+        double seconds = static_cast<double>( lines[ line ].size()) / _sampleRate;
+        double gain    = _mode == FREEZE_MODE ? 1.0 : std::pow( 10.0, -3.0 * seconds / std::max( 0.01, static_cast<double>( _decayTime )));
+
+        lineGain[ line ] = static_cast<float>( gain ) * scale;
+    }
+}
+
+void FdnReverb::clear()
+{
+    for ( int line = 0; line < NUM_LINES; ++line ) {
+        std::fill( lines[ line ].begin(), lines[ line ].end(), 0.f );
+        lineIndex  [ line ] = 0;
+        filterStore[ line ] = 0.f;
+    }
+
+    for ( int channel = 0; channel < MAX_CHANNELS; ++channel ) {
+        std::fill_n( inputRing [ channel ], RING_SIZE, 0.f );
+        std::fill_n( outputRing[ channel ], RING_SIZE, 0.f );
+    }
+    isEngaged = true;
+}
+
+void FdnReverb::render( int ringPosition, int frameCount )
+{
+    bool frozen = _mode == FREEZE_MODE;
+
+    float damp1 = frozen ? 0.f : _damp;
+    float damp2 = 1.f - damp1;
+    float gain  = frozen ? 0.f : INPUT_GAIN / std::sqrt( static_cast<float>( NUM_LINES )); // a frozen network receives no input
+
+    // read the output of each line (the block doesn't exceed the shortest line, so none of it is written by this block)
+
+    for ( int line = 0; line < NUM_LINES; ++line ) {
+        const float* buffer = lines[ line ].data();
+        int index = lineIndex[ line ];
+        int first = std::min( frameCount, static_cast<int>( lines[ line ].size()) - index );
+
+        for ( int frame = 0; frame < first; ++frame ) {
+            frames[ frame ][ line ] = buffer[ index + frame ];
+        }
+        for ( int frame = first; frame < frameCount; ++frame ) {
+            frames[ frame ][ line ] = buffer[ frame - first ];
+        }
+    }
+
+    // the filter state and gains are kept local for the duration of the block, so these can reside in (vector) registers
+
+    alignas( 32 ) float store[ NUM_LINES ];
+    alignas( 32 ) float gains[ NUM_LINES ];
+
+    std::copy_n( filterStore, NUM_LINES, store );
+    std::copy_n( lineGain,    NUM_LINES, gains );
+
+    // each channel is spread over all lines by a column of the matrix (e.g. as if added to a single line before the matrix)
+
+    alignas( 32 ) float leftColumn [ NUM_LINES ];
+    alignas( 32 ) float rightColumn[ NUM_LINES ];
+
+    for ( int line = 0; line < NUM_LINES; ++line ) {
+        leftColumn [ line ] = ( line & 1 ) == 0 ? gain : -gain;
+        rightColumn[ line ] = ( line & 2 ) == 0 ? gain : -gain;
+    }
+
+    float* leftInput   = inputRing [ 0 ] + ringPosition;
+    float* rightInput  = inputRing [ 1 ] + ringPosition;
+    float* leftOutput  = outputRing[ 0 ] + ringPosition;
+    float* rightOutput = outputRing[ 1 ] + ringPosition;
+
+    for ( int frame = 0; frame < frameCount; ++frame ) {
+        float* x = frames[ frame ];
+
+        // the left channel is tapped from the even lines, the right channel from the odd lines
+
+        leftOutput [ frame ] = 0.5f * ( x[ 0 ] - x[ 2 ] + x[ 4 ] - x[ 6 ]);
+        rightOutput[ frame ] = 0.5f * ( x[ 1 ] - x[ 3 ] + x[ 5 ] - x[ 7 ]);
+
+        // damp each line and apply its gain
+
+        alignas( 32 ) float v[ NUM_LINES ];
+
+        for ( int line = 0; line < NUM_LINES; ++line ) {
+            store[ line ] = x[ line ] * damp2 + store[ line ] * damp1;
+            v[ line ]     = store[ line ] * gains[ line ];
+        }
+
+        // feed all lines into each other through the Hadamard matrix (as a fast Walsh-Hadamard transform)
+
+        for ( int line = 0; line < 4; ++line ) {
+            float a = v[ line ], b = v[ line + 4 ];
+            v[ line ] = a + b; v[ line + 4 ] = a - b;
+        }
+        for ( int line = 0; line < 8; line += 4 ) {
+            for ( int i = line; i < line + 2; ++i ) {
+                float a = v[ i ], b = v[ i + 2 ];
+                v[ i ] = a + b; v[ i + 2 ] = a - b;
+            }
+        }
+        for ( int line = 0; line < 8; line += 2 ) {
+            float a = v[ line ], b = v[ line + 1 ];
+            v[ line ] = a + b; v[ line + 1 ] = a - b;
+        }
+
+        float left  = leftInput [ frame ];
+        float right = rightInput[ frame ];
+
+        for ( int line = 0; line < NUM_LINES; ++line ) {
+            x[ line ] = v[ line ] + left * leftColumn[ line ] + right * rightColumn[ line ];
+        }
+    }
+    std::fill_n( leftInput,  frameCount, 0.f );
+    std::fill_n( rightInput, frameCount, 0.f );
+
+    std::copy_n( store, NUM_LINES, filterStore );
+
+    // write the new input of each line
+
+    for ( int line = 0; line < NUM_LINES; ++line ) {
+        float* buffer = lines[ line ].data();
+        int size  = static_cast<int>( lines[ line ].size());
+        int index = lineIndex[ line ];
+        int first = std::min( frameCount, size - index );
+
+        for ( int frame = 0; frame < first; ++frame ) {
+            buffer[ index + frame ] = frames[ frame ][ line ];
+        }
+        for ( int frame = first; frame < frameCount; ++frame ) {
+            buffer[ frame - first ] = frames[ frame ][ line ];
+        }
+        lineIndex[ line ] = ( index + frameCount ) % size;
+    }
+}
+
+DELIRION_TARGET_BASELINE void FdnReverb::renderBaseline( int ringPosition, int frameCount )
+{
+    render( ringPosition, frameCount );
+}
+
+DELIRION_TARGET_AVX2 void FdnReverb::renderAvx2( int ringPosition, int frameCount )
+{
+    render( ringPosition, frameCount );
+}
+
+DELIRION_TARGET_AVX512 void FdnReverb::renderAvx512( int ringPosition, int frameCount )
+{
+    render( ringPosition, frameCount );
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "../../Parameters.h"
+#include "../../utils/Simd.h"
+#include <vector>
+
+/**
+ * Feedback delay network reverb: eight delay lines of which the (damped) output is fed back into all lines through
+ * an orthogonal Hadamard matrix. As each line feeds every other line, the echo density builds up much faster
+ * than with the parallel combs of Reverb, without requiring a series of allpasses. As the matrix is unity gain,
+ * the decay is determined by the line gains alone: freezing sets these to unity (and mutes the input).
+ *
+ * A single network is shared by all channels. Each channel is injected into all lines through its own column of
+ * the matrix and tapped from its own set of lines, so the channels remain decorrelated. As the network renders all channels at once,
+ * apply() only collects the input of a channel and returns the previously rendered output, after all channels
+ * have been applied advance() renders the network. The wet signal is thus delayed by PRE_DELAY samples.
+ *
+ * The lines are rendered in blocks no longer than the shortest line (so a block never reads what it writes),
+ * each line is read and written contiguously while the damping and matrix are applied to all lines at once
+ * (one line per SIMD lane).
+ */
+class FdnReverb
+{
+    public:
+        static constexpr int NUM_LINES    = Parameters::Config::NUM_FDN_LINES;
+        static constexpr int MAX_CHANNELS = 2; // additional channels share the vectors of the first channels
+        static constexpr int PRE_DELAY    = Parameters::Config::TILE_SIZE;
+
+        static const int INITIAL_MODE   = 0;
+        static const int FREEZE_MODE    = 1;
+        static const int FREEZE_PENDING = 2;
+
+        FdnReverb( double sampleRate, float decayTime, float damp );
+
+        inline bool isActive() {
+            return _wet > 0.f;
+        }
+
+        // collects the input of given channel and replaces it with the mixed output (at most PRE_DELAY samples)
+        void apply( int channel, float* channelData, int bufferSize );
+
+        // renders the network for the input collected since the last call (once all channels have been applied)
+        void advance( int bufferSize );
+
+        // clears the network once rendered again
+        void reset();
+
+        void setDecayTime( float value ); // RT60, in seconds
+        float getDecayTime();
+        void setDamp( float value );
+        float getDamp();
+        void setWet( float value );
+        float getWet();
+        void setDry( float value );
+        float getDry();
+        int getMode();
+        void setMode( int value );
+
+        // selects the variant of the rendering kernel for given instruction set (see Simd). Not to be called during rendering
+
+        void setSimdLevel( int level );
+
+    private:
+        static const int MAX_BLOCK = 64; // frames rendered at a time (when the shortest line allows it)
+        static const int RING_SIZE = PRE_DELAY * 2;
+
+        static constexpr float INPUT_GAIN = 0.3f; // matches the frozen level of Reverb
+
+        double _sampleRate;
+        float _decayTime;
+        float _damp;
+        float _wet = 0.f;
+        float _dry = 1.f;
+        int _mode  = INITIAL_MODE;
+        int _freezeDelay = 0;
+
+        bool isEngaged = false; // whether the reverb was active in the previous block
+        int position   = 0;     // within the input and output rings
+
+        std::vector<float> lines[ NUM_LINES ];
+        int lineIndex[ NUM_LINES ] = {};
+        int shortestLine;
+
+        alignas( 32 ) float lineGain[ NUM_LINES ];    // feedback gain of each line (derived from the decay time)
+        alignas( 32 ) float filterStore[ NUM_LINES ]; // damping filter state of each line
+        alignas( 32 ) float frames[ MAX_BLOCK ][ NUM_LINES ];
+
+        // the collected input and rendered output of each channel
+
+        float inputRing [ MAX_CHANNELS ][ RING_SIZE ];
+        float outputRing[ MAX_CHANNELS ][ RING_SIZE ];
+
+        void update();
+        void clear();
+        void render( int ringPosition, int frameCount );
+        void renderBaseline( int ringPosition, int frameCount );
+        void renderAvx2    ( int ringPosition, int frameCount );
+        void renderAvx512  ( int ringPosition, int frameCount );
+
+        using Variant = void ( FdnReverb::* )( int, int );
+        Variant variant = &FdnReverb::renderBaseline;
+
+        JUCE_DECLARE_NON_COPYABLE( FdnReverb )
+};
@@ -24,39 +24,34 @@
 #include "Reverb.h"
 #include "../../utils/Calc.h"
 
-Reverb::Reverb( double sampleRate, float width, float roomSize )
+template <typename SampleType>
+Reverb<SampleType>::Reverb( double sampleRate, float width, float roomSize )
 {
     _sampleRate = static_cast<float>( sampleRate );
 
-    setupFilters();
-
     setWet     ( INITIAL_WET );
     setRoomSize( roomSize );
     setDry     ( INITIAL_DRY );
     setDamp    ( INITIAL_DAMP );
     setWidth   ( width );
     setMode    ( INITIAL_MODE );
-
-    // this will initialize the buffers with silence
-    mute();
 }
 
-Reverb::~Reverb()
+template <typename SampleType>
+Reverb<SampleType>::~Reverb()
 {
     clearFilters();
 }
 
-void Reverb::apply( juce::AudioBuffer<float>& buffer, int channel )
+template <typename SampleType>
+void Reverb<SampleType>::apply( SampleType* channelData, int bufferSize )
 {
     if ( !isActive() ) {
         return;
     }
-    auto* channelData = buffer.getWritePointer( channel );
-    int bufferSize    = buffer.getNumSamples();
 
-    for ( int i = 0; i < bufferSize; ++i ) {
-        channelData[ i ] = processSingle( channelData[ i ]);
-    }
+    ( this->*variant )( channelData, bufferSize );
+
     if ( _mode == FREEZE_PENDING ) {
         _freezeDelay -= bufferSize;
         if ( _freezeDelay <= 0 ) {
@@ -66,9 +61,47 @@ void Reverb::apply( juce::AudioBuffer<float>& buffer, int channel )
     }
 }
 
-void Reverb::mute()
+template <typename SampleType>
+void Reverb<SampleType>::setSimdLevel( int level )
+{
+    variant = Simd::select<Variant>( level, &Reverb::renderBaseline, &Reverb::renderAvx2, &Reverb::renderAvx512 );
+}
+
+template <typename SampleType>
+size_t Reverb<SampleType>::getMemorySize()
+{
+    size_t size = 0;
+
+    for ( int i = 0; i < Parameters::Config::NUM_COMBS; ++i ) {
+        size += static_cast<size_t>( getFilterSize( Parameters::Config::COMB_TUNINGS[ i ]));
+    }
+
+    for ( int i = 0; i < Parameters::Config::NUM_ALLPASSES; ++i ) {
+        size += static_cast<size_t>( getFilterSize( Parameters::Config::ALLPASS_TUNINGS[ i ]));
+    }
+    return size * sizeof( SampleType ) / sizeof( float );
+}
+
+template <typename SampleType>
+void Reverb<SampleType>::allocate( float* memory )
+{
+    setupFilters( reinterpret_cast<SampleType*>( memory ));
+    update();
+
+    // this will initialize the buffers with silence
+    mute();
+}
+
+template <typename SampleType>
+void Reverb<SampleType>::release()
+{
+    clearFilters();
+}
+
+template <typename SampleType>
+void Reverb<SampleType>::mute()
 {
-    if ( getMode() == FREEZE_MODE ) {
+    if ( getMode() == FREEZE_MODE || _combFilter == nullptr ) {
         return;
     }
 
@@ -81,66 +114,78 @@ void Reverb::mute()
     }
 }
 
-float Reverb::getRoomSize()
+template <typename SampleType>
+float Reverb<SampleType>::getRoomSize()
 {
     return ( _roomSize - OFFSET_ROOM ) / SCALE_ROOM;
 }
 
-void Reverb::setRoomSize( float value )
+template <typename SampleType>
+void Reverb<SampleType>::setRoomSize( float value )
 {
     _roomSize = ( value * SCALE_ROOM ) + OFFSET_ROOM;
     update();
 }
 
-float Reverb::getDamp()
+template <typename SampleType>
+float Reverb<SampleType>::getDamp()
 {
     return _damp / SCALE_DAMP;
 }
 
-void Reverb::setDamp( float value )
+template <typename SampleType>
+void Reverb<SampleType>::setDamp( float value )
 {
     _damp = value * SCALE_DAMP;
     update();
 }
 
-float Reverb::getWet()
+template <typename SampleType>
+float Reverb<SampleType>::getWet()
 {
     return _wet / SCALE_WET;
 }
 
-void Reverb::setWet( float value )
+template <typename SampleType>
+void Reverb<SampleType>::setWet( float value )
 {
     _wet = value * SCALE_WET;
     update();
 }
 
-float Reverb::getDry()
+template <typename SampleType>
+float Reverb<SampleType>::getDry()
 {
     return _dry / SCALE_DRY;
 }
 
-void Reverb::setDry( float value )
+template <typename SampleType>
+void Reverb<SampleType>::setDry( float value )
 {
     _dry = value * SCALE_DRY;
 }
 
-float Reverb::getWidth()
+template <typename SampleType>
+float Reverb<SampleType>::getWidth()
 {
     return _width;
 }
 
-void Reverb::setWidth( float value )
+template <typename SampleType>
+void Reverb<SampleType>::setWidth( float value )
 {
     _width = value;
     update();
 }
 
-int Reverb::getMode()
+template <typename SampleType>
+int Reverb<SampleType>::getMode()
 {
     return _mode;
 }
 
-void Reverb::setMode( int value )
+template <typename SampleType>
+void Reverb<SampleType>::setMode( int value )
 {
     int currentMode = _mode;
 
@@ -157,31 +202,32 @@ void Reverb::setMode( int value )
     }
 }
 
-void Reverb::toggleFreeze()
+template <typename SampleType>
+void Reverb<SampleType>::toggleFreeze()
 {
     setMode( getMode() == FREEZE_MODE ? INITIAL_MODE : FREEZE_MODE );
 }
 
-void Reverb::setupFilters()
+template <typename SampleType>
+void Reverb<SampleType>::setupFilters( SampleType* memory )
 {
     clearFilters();
 
-    // create filters and buffers per output channel
+    // create filters, their buffers are laid out consecutively in the provided memory
 
     // comb filter
-    _combFilter = new CombFilter();
+    _combFilter   = new CombFilter();
+    _shortestComb = MAX_FRAMES;
 
     for ( int i = 0; i < Parameters::Config::NUM_COMBS; ++i ) {
-        // tune the comb to the host environments sample rate
-        int tuning = ( int ) ((( float ) Parameters::Config::COMB_TUNINGS[ i ] / 44100.f ) * _sampleRate );
-        int size = tuning + ( /*c **/ STEREO_SPREAD );
-        float* buffer = new float[ static_cast<unsigned long>( size )];
+        int size = getFilterSize( Parameters::Config::COMB_TUNINGS[ i ]);
 
-        auto comb = new Comb();
-        comb->setBuffer( buffer, size );
+        auto comb = new Comb<SampleType>();
+        comb->setBuffer( memory, size );
+        memory += size;
 
         _combFilter->filters.push_back( comb );
-        _combFilter->buffers.push_back( buffer );
+        _shortestComb = std::min( _shortestComb, size );
     }
 
     // all pass filter
@@ -189,26 +235,28 @@ void Reverb::setupFilters()
     _allpassFilter = new AllPassFilter();
 
     for ( int i = 0; i < Parameters::Config::NUM_ALLPASSES; ++i ) {
-        // tune the comb to the host environments sample rate
-        int tuning = ( int ) ((( float ) Parameters::Config::ALLPASS_TUNINGS[ i ] / 44100.f ) * _sampleRate );
-        int size = tuning + ( /*c **/ STEREO_SPREAD );
-        float* buffer = new float[ static_cast<unsigned long>( size )];
+        int size = getFilterSize( Parameters::Config::ALLPASS_TUNINGS[ i ]);
 
-        auto allPass = new AllPass();
-        allPass->setBuffer( buffer, size );
+        auto allPass = new AllPass<SampleType>();
+        allPass->setBuffer( memory, size );
+        memory += size;
 
         _allpassFilter->filters.push_back( allPass );
-        _allpassFilter->buffers.push_back( buffer );
     }
 }
 
-void Reverb::clearFilters()
+template <typename SampleType>
+void Reverb<SampleType>::clearFilters()
 {
     delete _combFilter;
     delete _allpassFilter;
+
+    _combFilter    = nullptr;
+    _allpassFilter = nullptr;
 }
 
-void Reverb::update()
+template <typename SampleType>
+void Reverb<SampleType>::update()
 {
     // Recalculate internal values after parameter change
 
@@ -226,9 +274,122 @@ void Reverb::update()
         _gain      = FIXED_GAIN;
     }
 
+    if ( _combFilter == nullptr ) {
+        return; // values are applied to the filters once allocated
+    }
+
     for ( size_t i = 0; i < Parameters::Config::NUM_COMBS; i++ ) {
         _combFilter->filters.at( i )->setFeedback( _roomSize1 );
         _combFilter->filters.at( i )->setDamp( _damp1 );
     }
 }
 
+/* kernels */
+
+// renders the same result as processSingle() for each sample, but processes the (parallel) combs as a bank: the output
+// of all combs is read for a block of frames, after which each frame is rendered for all combs at once (one comb
+// per SIMD lane). The blocks don't exceed the shortest comb, so a block never reads what it writes.
+// The allpasses (which are in series) are applied to the entire block in succession
+
+template <typename SampleType>
+void Reverb<SampleType>::render( SampleType* channelData, int bufferSize )
+{
+    auto& combs = _combFilter->filters;
+
+    alignas( 32 ) SampleType frames[ MAX_FRAMES ][ NUM_COMBS ];
+    alignas( 32 ) SampleType store[ NUM_COMBS ], damp1[ NUM_COMBS ], damp2[ NUM_COMBS ], feedback[ NUM_COMBS ];
+    SampleType processed[ MAX_FRAMES ];
+
+    for ( int comb = 0; comb < NUM_COMBS; ++comb ) {
+        store   [ comb ] = combs[ comb ]->_filterStore;
+        damp1   [ comb ] = combs[ comb ]->_damp1;
+        damp2   [ comb ] = combs[ comb ]->_damp2;
+        feedback[ comb ] = combs[ comb ]->_feedback;
+    }
+
+    for ( int offset = 0; offset < bufferSize; ) {
+        int frameCount = std::min({ bufferSize - offset, MAX_FRAMES, _shortestComb });
+        SampleType* data = channelData + offset;
+
+        for ( int comb = 0; comb < NUM_COMBS; ++comb ) {
+            const SampleType* buffer = combs[ comb ]->_buffer;
+            int index = combs[ comb ]->_bufIndex;
+            int first = std::min( frameCount, combs[ comb ]->_bufSize - index );
+
+            for ( int frame = 0; frame < first; ++frame ) {
+                frames[ frame ][ comb ] = buffer[ index + frame ];
+            }
+            for ( int frame = first; frame < frameCount; ++frame ) {
+                frames[ frame ][ comb ] = buffer[ frame - first ];
+            }
+        }
+
+        for ( int frame = 0; frame < frameCount; ++frame ) {
+            SampleType input = data[ frame ] * _gain;
+            SampleType* x    = frames[ frame ];
+            SampleType sum   = 0;
+
+            for ( int comb = 0; comb < NUM_COMBS; ++comb ) {
+                sum += x[ comb ]; // (in order of the combs, as with processSingle())
+            }
+            for ( int comb = 0; comb < NUM_COMBS; ++comb ) {
+                store[ comb ] = ( x[ comb ] * damp2[ comb ]) + ( store[ comb ] * damp1[ comb ]);
+                x[ comb ]     = input + ( store[ comb ] * feedback[ comb ]);
+            }
+            processed[ frame ] = sum;
+        }
+
+        for ( int comb = 0; comb < NUM_COMBS; ++comb ) {
+            SampleType* buffer = combs[ comb ]->_buffer;
+            int size  = combs[ comb ]->_bufSize;
+            int index = combs[ comb ]->_bufIndex;
+            int first = std::min( frameCount, size - index );
+
+            for ( int frame = 0; frame < first; ++frame ) {
+                buffer[ index + frame ] = frames[ frame ][ comb ];
+            }
+            for ( int frame = first; frame < frameCount; ++frame ) {
+                buffer[ frame - first ] = frames[ frame ][ comb ];
+            }
+            combs[ comb ]->_bufIndex = ( index + frameCount ) % size;
+        }
+
+        for ( size_t i = 0; i < Parameters::Config::NUM_ALLPASSES; i++ ) {
+            auto* allpass = _allpassFilter->filters[ i ];
+
+            for ( int frame = 0; frame < frameCount; ++frame ) {
+                processed[ frame ] = allpass->process( processed[ frame ]);
+            }
+        }
+
+        for ( int frame = 0; frame < frameCount; ++frame ) {
+            data[ frame ] = ( processed[ frame ] * _wet1 ) + (( data[ frame ] * _gain ) * _dry );
+        }
+        offset += frameCount;
+    }
+
+    for ( int comb = 0; comb < NUM_COMBS; ++comb ) {
+        combs[ comb ]->_filterStore = store[ comb ];
+    }
+}
+
+template <typename SampleType>
+DELIRION_TARGET_BASELINE void Reverb<SampleType>::renderBaseline( SampleType* channelData, int bufferSize )
+{
+    render( channelData, bufferSize );
+}
+
+template <typename SampleType>
+DELIRION_TARGET_AVX2 void Reverb<SampleType>::renderAvx2( SampleType* channelData, int bufferSize )
+{
+    render( channelData, bufferSize );
+}
+
+template <typename SampleType>
+DELIRION_TARGET_AVX512 void Reverb<SampleType>::renderAvx512( SampleType* channelData, int bufferSize )
+{
+    render( channelData, bufferSize );
+}
+
+template class Reverb<float>;
+template class Reverb<double>;
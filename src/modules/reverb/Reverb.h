@@ -20,39 +20,34 @@
 #include "Comb.h"
 #include "Allpass.h"
 #include "../../Parameters.h"
+#include "../../utils/Simd.h"
 #include <vector>
 
+/**
+ * Freeverb reverb rendering samples of given type (its filter buffers and state are kept in the same type)
+ */
+template <typename SampleType>
 class Reverb {
 
     struct CombFilter {
-        std::vector<Comb*> filters;
-        std::vector<float*> buffers;
+        std::vector<Comb<SampleType>*> filters;
 
         ~CombFilter() {
             while ( !filters.empty() ) {
                 delete filters.at( 0 );
                 filters.erase( filters.begin() );
             }
-            while ( !buffers.empty() ) {
-                delete buffers.at( 0 );
-                buffers.erase( buffers.begin() );
-            }
         }
     };
 
     struct AllPassFilter {
-        std::vector<AllPass*> filters;
-        std::vector<float*> buffers;
+        std::vector<AllPass<SampleType>*> filters;
 
         ~AllPassFilter() {
             while ( !filters.empty() ) {
                 delete filters.at( 0 );
                 filters.erase( filters.begin() );
             }
-            while ( !buffers.empty() ) {
-                delete buffers.at( 0 );
-                buffers.erase( buffers.begin() );
-            }
         }
     };
 
@@ -82,13 +77,28 @@ class Reverb {
             return _wet > 0.f;
         }
 
-        void apply( juce::AudioBuffer<float>& buffer, int channel );
+        void apply( SampleType* channelData, int bufferSize );
+
+        // selects the variant of the reverb kernel for given instruction set (see Simd). Not to be called during rendering
+
+        void setSimdLevel( int level );
+
+        // the amount of floats required for the comb and allpass filter buffers (e.g. twice the
+        // amount of samples when rendering in double precision)
+
+        size_t getMemorySize();
 
-        inline float processSingle( float inputSample ) {
+        // assigns/detaches the comb and allpass filter buffers (the provided memory should hold getMemorySize() floats
+        // and is owned by the caller), the reverb should not be applied while released (its properties can be set at all times)
+
+        void allocate( float* memory );
+        void release();
+
+        inline SampleType processSingle( SampleType inputSample ) {
 
             // ---- REVERB process
 
-            float processedSample = 0;
+            SampleType processedSample = 0;
             inputSample *= _gain;
 
             // accumulate comb filters in parallel
@@ -123,10 +133,27 @@ class Reverb {
         void toggleFreeze();
 
     private:
-        void setupFilters(); // generates comb and allpass filter buffers
-        void clearFilters(); // frees memory allocated to comb and allpass filter buffers
+        static const int NUM_COMBS  = Parameters::Config::NUM_COMBS;
+        static const int MAX_FRAMES = 64; // frames rendered at a time by the comb bank
+
+        using Variant = void ( Reverb::* )( SampleType*, int );
+        Variant variant = &Reverb::renderBaseline;
+
+        void render( SampleType* channelData, int bufferSize );
+        void renderBaseline( SampleType* channelData, int bufferSize );
+        void renderAvx2    ( SampleType* channelData, int bufferSize );
+        void renderAvx512  ( SampleType* channelData, int bufferSize );
+
+        void setupFilters( SampleType* memory ); // generates comb and allpass filters using given buffer memory
+        void clearFilters(); // frees comb and allpass filters
         void update();
 
+        inline int getFilterSize( int tuning )
+        {
+            // tune the filter to the host environments sample rate
+            return static_cast<int>(( static_cast<float>( tuning ) / 44100.f ) * _sampleRate ) + STEREO_SPREAD;
+        }
+
         float _gain;
         float _roomSize, _roomSize1;
         float _damp, _damp1;
@@ -136,6 +163,7 @@ class Reverb {
         int _mode;
         float _sampleRate;
         int _freezeDelay = 0;
+        int _shortestComb = MAX_FRAMES;
 
         CombFilter*    _combFilter    = nullptr;
         AllPassFilter* _allpassFilter = nullptr;
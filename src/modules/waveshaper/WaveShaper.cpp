@@ -25,7 +25,8 @@
 
 // constructor
 
-WaveShaper::WaveShaper( float amount, float level )
+template <typename SampleType>
+WaveShaper<SampleType>::WaveShaper( float amount, float level )
 {
     setAmount( amount );
     setLevel ( level );
@@ -33,37 +34,75 @@ WaveShaper::WaveShaper( float amount, float level )
 
 /* public methods */
 
-void WaveShaper::apply( juce::AudioBuffer<float>& buffer, int channel )
+template <typename SampleType>
+void WaveShaper<SampleType>::apply( SampleType* channelData, int bufferSize )
 {
-    auto* channelData = buffer.getWritePointer( channel );
-    int bufferSize    = buffer.getNumSamples();
+    ( this->*variant )( channelData, bufferSize );
+}
 
-    for ( int i = 0; i < bufferSize; ++i )
-    {
-        float input = channelData[ i ];
-        channelData[ i ] =  (( 1.f + _multiplier ) * input / ( 1.f + _multiplier * std::abs( input ))) * _level;
-    }
+template <typename SampleType>
+void WaveShaper<SampleType>::setSimdLevel( int level )
+{
+    variant = Simd::select<Variant>( level, &WaveShaper::applyBaseline, &WaveShaper::applyAvx2, &WaveShaper::applyAvx512 );
 }
 
 /* getters / setters */
 
-float WaveShaper::getAmount()
+template <typename SampleType>
+float WaveShaper<SampleType>::getAmount()
 {
     return _amount;
 }
 
-void WaveShaper::setAmount( float value )
+template <typename SampleType>
+void WaveShaper<SampleType>::setAmount( float value )
 {
     _amount     = value;
     _multiplier = 2.0f * _amount / ( 1.0f - fmin(0.99999f, _amount));
 }
 
-float WaveShaper::getLevel()
+template <typename SampleType>
+float WaveShaper<SampleType>::getLevel()
 {
     return _level;
 }
 
-void WaveShaper::setLevel( float value )
+template <typename SampleType>
+void WaveShaper<SampleType>::setLevel( float value )
 {
     _level = value;
 }
+
+/* private methods */
+
+template <typename SampleType>
+void WaveShaper<SampleType>::render( SampleType* channelData, int bufferSize )
+{
+    Kernel transfer = getKernel();
+
+    for ( int i = 0; i < bufferSize; ++i )
+    {
+        channelData[ i ] = transfer.process( channelData[ i ], i );
+    }
+}
+
+template <typename SampleType>
+DELIRION_TARGET_BASELINE void WaveShaper<SampleType>::applyBaseline( SampleType* channelData, int bufferSize )
+{
+    render( channelData, bufferSize );
+}
+
+template <typename SampleType>
+DELIRION_TARGET_AVX2 void WaveShaper<SampleType>::applyAvx2( SampleType* channelData, int bufferSize )
+{
+    render( channelData, bufferSize );
+}
+
+template <typename SampleType>
+DELIRION_TARGET_AVX512 void WaveShaper<SampleType>::applyAvx512( SampleType* channelData, int bufferSize )
+{
+    render( channelData, bufferSize );
+}
+
+template class WaveShaper<float>;
+template class WaveShaper<double>;
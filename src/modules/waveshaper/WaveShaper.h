@@ -23,19 +23,53 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
+#include <cmath>
+#include "../../utils/Simd.h"
 
+/**
+ * Waveshaper rendering samples of given type (the amount and level remain single precision)
+ */
+template <typename SampleType>
 class WaveShaper
 {
     public:
+        // the transfer function of a single sample (e.g. to apply the waveshaper as a stage of a Chain)
+
+        struct Kernel
+        {
+            inline SampleType process( SampleType input, int /* index */ ) const
+            {
+                return (( SampleType( 1 ) + multiplier ) * input / ( SampleType( 1 ) + multiplier * std::abs( input ))) * level;
+            }
+
+            SampleType multiplier;
+            SampleType level;
+        };
+
         WaveShaper( float amount, float level );
 
+        inline Kernel getKernel() const {
+            return { static_cast<SampleType>( _multiplier ), static_cast<SampleType>( _level ) };
+        }
+
         float getAmount();
         void setAmount( float value ); // range between -1 and +1
         float getLevel();
         void setLevel( float value );
-        void apply( juce::AudioBuffer<float>& buffer, int channel );
+        void apply( SampleType* channelData, int bufferSize );
+
+        // selects the variant of the waveshaper kernel for given instruction set (see Simd)
+        void setSimdLevel( int level );
 
     private:
+        using Variant = void ( WaveShaper::* )( SampleType*, int );
+        Variant variant = &WaveShaper::applyBaseline;
+
+        void render       ( SampleType* channelData, int bufferSize );
+        void applyBaseline( SampleType* channelData, int bufferSize );
+        void applyAvx2    ( SampleType* channelData, int bufferSize );
+        void applyAvx512  ( SampleType* channelData, int bufferSize );
+
         float _amount;
         float _multiplier;
         float _level;
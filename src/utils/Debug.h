@@ -1,36 +1,145 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
+#include <vector>
 
 /**
- * Convenience utility to log messages
- * by appending onto a log file (which is cleared
- * whenever a new Debug instance is instantiated)
+ * Convenience utility to log messages by appending onto a log file
+ * (which is cleared whenever a new Debug instance is instantiated)
+ *
+ * Logging is real-time safe: log() copies the message and its (optional) values
+ * into a preallocated entry of a lock-free ring buffer without allocating or locking.
+ * A background thread formats the entries and writes them to disk. Only a single
+ * thread should call log() at a time.
  */
-class Debug
+class Debug : private juce::Thread
 {
     public:
-        Debug()
+        static const int MAX_MESSAGE_LENGTH = 128;
+        static const int MAX_VALUES         = 32;
+        static const int CAPACITY           = 256; // in entries
+
+        Debug( const juce::String& fileName = "plugin_log.txt" ) : juce::Thread( "Delirion log writer" ), fifo( CAPACITY )
         {
-            logFile = juce::File::getSpecialLocation( juce::File::userDocumentsDirectory ).getChildFile( "plugin_log.txt" );
+            entries.resize( CAPACITY );
+
+            logFile = juce::File::getSpecialLocation( juce::File::userDocumentsDirectory ).getChildFile( fileName );
 
             // Create or overwrite the log file
             if ( logFile.existsAsFile()) {
                 logFile.deleteFile();
             }
             logFile.create();
+
+            startThread( juce::Thread::Priority::background );
+        }
+
+        ~Debug() override
+        {
+            stopThread( FLUSH_INTERVAL_MS * 10 );
+            flush();
         }
 
         void log( const juce::String& message )
         {
-            juce::FileOutputStream outputStream( logFile );
+            log( message.toRawUTF8(), nullptr, nullptr, 0 );
+        }
+
+        void log( const char* message, float value )
+        {
+            log( message, &value, nullptr, 1 );
+        }
 
-            if ( outputStream.openedOk()) {
-                juce::String timeStampedMessage = juce::Time::getCurrentTime().toString( true, true ) + ": " + message + "\n";
-                outputStream.writeText( timeStampedMessage, false, false, nullptr );
+        /**
+         * logs a message along with a list of (optionally named) values,
+         * valueNames must remain valid until the entry has been written (e.g. be string literals)
+         */
+        void log( const char* message, const float* values, const char* const* valueNames, int numValues )
+        {
+            int start1, size1, start2, size2;
+            fifo.prepareToWrite( 1, start1, size1, start2, size2 );
+
+            if ( size1 + size2 == 0 ) {
+                droppedEntries.fetch_add( 1, std::memory_order_relaxed );
+                return;
             }
+            auto& entry = entries[ static_cast<size_t>( size1 > 0 ? start1 : start2 )];
+
+            entry.timestamp = juce::Time::currentTimeMillis();
+            strncpy( entry.message, message, MAX_MESSAGE_LENGTH - 1 );
+            entry.message[ MAX_MESSAGE_LENGTH - 1 ] = '\0';
+
+            entry.numValues = std::min( numValues, MAX_VALUES );
+            for ( int i = 0; i < entry.numValues; ++i ) {
+                entry.values[ i ]     = values[ i ];
+                entry.valueNames[ i ] = valueNames != nullptr ? valueNames[ i ] : nullptr;
+            }
+            fifo.finishedWrite( 1 ); // note we don't notify() the writing thread as that could lock
         }
 
     private:
+        static const int FLUSH_INTERVAL_MS = 500;
+
+        struct Entry {
+            juce::int64 timestamp;
+            char message[ MAX_MESSAGE_LENGTH ];
+            float values[ MAX_VALUES ];
+            const char* valueNames[ MAX_VALUES ];
+            int numValues;
+        };
+
+        void run() override
+        {
+            while ( !threadShouldExit()) {
+                flush();
+                wait( FLUSH_INTERVAL_MS );
+            }
+        }
+
+        void flush()
+        {
+            int start1, size1, start2, size2;
+            fifo.prepareToRead( fifo.getNumReady(), start1, size1, start2, size2 );
+
+            int dropped = droppedEntries.exchange( 0 );
+
+            if ( size1 + size2 == 0 && dropped == 0 ) {
+                return;
+            }
+            juce::FileOutputStream outputStream( logFile );
+
+            auto writeEntries = [ & ]( int start, int amount )
+            {
+                for ( int i = start; i < start + amount; ++i ) {
+                    auto& entry = entries[ static_cast<size_t>( i )];
+                    juce::String line = juce::Time( entry.timestamp ).toString( true, true ) + ": " + entry.message;
+
+                    for ( int v = 0; v < entry.numValues; ++v ) {
+                        line += v == 0 ? " (" : ", ";
+                        if ( entry.valueNames[ v ] != nullptr ) {
+                            line += juce::String( entry.valueNames[ v ]) + " = ";
+                        }
+                        line += juce::String( entry.values[ v ]);
+                    }
+                    line += entry.numValues > 0 ? ")\n" : "\n";
+
+                    if ( outputStream.openedOk()) {
+                        outputStream.writeText( line, false, false, nullptr );
+                    }
+                }
+            };
+            writeEntries( start1, size1 );
+            writeEntries( start2, size2 );
+
+            fifo.finishedRead( size1 + size2 );
+
+            if ( dropped > 0 && outputStream.openedOk()) {
+                outputStream.writeText( "(" + juce::String( dropped ) + " messages dropped)\n", false, false, nullptr );
+            }
+        }
+
         juce::File logFile;
+        juce::AbstractFifo fifo;
+        std::vector<Entry> entries;
+        std::atomic<int> droppedEntries { 0 };
 };
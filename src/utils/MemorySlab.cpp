@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "MemorySlab.h"
+#include <cstring>
+
+#if JUCE_WINDOWS
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+#if JUCE_LINUX
+static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+#endif
+
+MemorySlab::~MemorySlab()
+{
+    release();
+}
+
+/* public methods */
+
+bool MemorySlab::reserve( size_t numFloats, bool shouldLockPages )
+{
+    release();
+
+    lockPages      = shouldLockPages;
+    hasLockFailure = false;
+    reservedBytes  = alignToPage( numFloats ) * sizeof( float );
+
+    if ( reservedBytes == 0 ) {
+        return true;
+    }
+
+#if JUCE_WINDOWS
+    mappedBytes = reservedBytes;
+    mapping     = VirtualAlloc( nullptr, mappedBytes, MEM_RESERVE, PAGE_READWRITE );
+
+    if ( mapping == nullptr ) {
+        reservedBytes = 0;
+        return false;
+    }
+    data = static_cast<float*>( mapping );
+#else
+    mappedBytes = reservedBytes;
+
+   #if JUCE_LINUX
+    // over-reserve so the slab can start at a huge page boundary
+    mappedBytes += HUGE_PAGE_SIZE;
+   #endif
+
+    mapping = mmap( nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+
+    if ( mapping == MAP_FAILED ) {
+        mapping = nullptr;
+        reservedBytes = 0;
+        return false;
+    }
+    data = static_cast<float*>( mapping );
+
+   #if JUCE_LINUX
+    auto address = reinterpret_cast<uintptr_t>( mapping );
+    data = reinterpret_cast<float*>(( address + HUGE_PAGE_SIZE - 1 ) & ~( HUGE_PAGE_SIZE - 1 ));
+
+    madvise( data, reservedBytes, MADV_HUGEPAGE ); // not fatal when unsupported
+   #endif
+#endif
+    return true;
+}
+
+void MemorySlab::release()
+{
+    if ( mapping == nullptr ) {
+        return;
+    }
+
+#if JUCE_WINDOWS
+    VirtualFree( mapping, 0, MEM_RELEASE );
+#else
+    munmap( mapping, mappedBytes ); // also unlocks locked pages
+#endif
+
+    mapping = nullptr;
+    data    = nullptr;
+    mappedBytes    = 0;
+    reservedBytes  = 0;
+    committedBytes = 0;
+}
+
+float* MemorySlab::commit( size_t offset, size_t numFloats )
+{
+    jassert( offset == alignToPage( offset ));
+
+    // nothing can be committed outside of the reserved range (e.g. when reserving failed)
+
+    if ( data == nullptr || ( offset + numFloats ) * sizeof( float ) > reservedBytes ) {
+        return nullptr;
+    }
+    float* region = data + offset;
+    size_t bytes  = alignToPage( numFloats ) * sizeof( float );
+
+    if ( bytes == 0 ) {
+        return region;
+    }
+
+#if JUCE_WINDOWS
+    if ( VirtualAlloc( region, bytes, MEM_COMMIT, PAGE_READWRITE ) == nullptr ) {
+        return nullptr;
+    }
+#endif
+
+    // writing the region prefaults its pages
+
+    std::memset( region, 0, bytes );
+
+    if ( lockPages ) {
+#if JUCE_WINDOWS
+        bool locked = VirtualLock( region, bytes ) != 0;
+#else
+        bool locked = mlock( region, bytes ) == 0;
+#endif
+        // locking can be denied by the systems resource limits, the memory remains prefaulted
+
+        hasLockFailure = hasLockFailure || !locked;
+    }
+    committedBytes += bytes;
+
+    return region;
+}
+
+void MemorySlab::decommit( size_t offset, size_t numFloats )
+{
+    float* region = data + offset;
+    size_t bytes  = alignToPage( numFloats ) * sizeof( float );
+
+    if ( bytes == 0 ) {
+        return;
+    }
+
+#if JUCE_WINDOWS
+    if ( lockPages ) {
+        VirtualUnlock( region, bytes );
+    }
+    VirtualFree( region, bytes, MEM_DECOMMIT );
+#else
+    if ( lockPages ) {
+        munlock( region, bytes );
+    }
+   #if JUCE_LINUX
+    madvise( region, bytes, MADV_DONTNEED );
+   #else
+    madvise( region, bytes, MADV_FREE );
+   #endif
+#endif
+    committedBytes -= std::min( committedBytes, bytes );
+}
+
+size_t MemorySlab::alignToPage( size_t numFloats )
+{
+    size_t floatsPerPage = getPageSize() / sizeof( float );
+
+    return (( numFloats + floatsPerPage - 1 ) / floatsPerPage ) * floatsPerPage;
+}
+
+/* private methods */
+
+size_t MemorySlab::getPageSize()
+{
+#if JUCE_WINDOWS
+    static const size_t pageSize = []()
+    {
+        SYSTEM_INFO info;
+        GetSystemInfo( &info );
+        return static_cast<size_t>( info.dwPageSize );
+    }();
+#else
+    static const size_t pageSize = static_cast<size_t>( sysconf( _SC_PAGESIZE ));
+#endif
+    return pageSize;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+/**
+ * Reserves the delay-line memory of a plugin instance as a single slab of virtual memory.
+ *
+ * Regions within the slab are committed individually (e.g. per band) by the message thread.
+ * Committing a region prefaults its pages (and optionally locks them in physical memory) so
+ * the audio thread never triggers a page fault when first accessing it. Decommitting returns the
+ * pages of a region to the system while keeping its address range reserved. On Linux the slab
+ * is aligned to, and advised for, transparent huge pages to reduce TLB pressure.
+ *
+ * Offsets and sizes are expressed in floats, region offsets must be obtained via alignToPage().
+ * Not thread safe, reserve(), commit(), decommit() and release() should not be called during rendering.
+ */
+class MemorySlab
+{
+    public:
+        MemorySlab() = default;
+        ~MemorySlab();
+
+        // reserves address space for given amount of floats without committing any memory
+        // when lockPages is true, committed regions are locked into physical memory (where permitted)
+
+        bool reserve( size_t numFloats, bool lockPages );
+        void release();
+
+        // commits the region at given offset, returning a pointer to its (zeroed) contents
+        // or nullptr when the memory could not be committed (e.g. exceeding the commit limit or the reserved range)
+        float* commit( size_t offset, size_t numFloats );
+        void decommit( size_t offset, size_t numFloats );
+
+        // rounds given amount of floats up to a multiple of the system page size
+        static size_t alignToPage( size_t numFloats );
+
+        inline size_t getReservedBytes() const
+        {
+            return reservedBytes;
+        }
+
+        inline size_t getCommittedBytes() const
+        {
+            return committedBytes;
+        }
+
+        // whether all committed regions could be locked into physical memory
+        inline bool isLocked() const
+        {
+            return lockPages && !hasLockFailure;
+        }
+
+    private:
+        static size_t getPageSize();
+
+        float* data     = nullptr;
+        void*  mapping  = nullptr; // start of the mapping (can precede data when aligned for huge pages)
+        size_t mappedBytes    = 0;
+        size_t reservedBytes  = 0;
+        size_t committedBytes = 0;
+        bool lockPages      = false;
+        bool hasLockFailure = false;
+
+        JUCE_DECLARE_NON_COPYABLE( MemorySlab )
+};
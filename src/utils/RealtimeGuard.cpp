@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "RealtimeGuard.h"
+
+#if DELIRION_RT_CHECKS
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if JUCE_WINDOWS
+#include <malloc.h>
+#endif
+
+#if JUCE_LINUX
+#include <dlfcn.h>
+#include <pthread.h>
+
+extern "C" void* __libc_malloc( size_t size );
+extern "C" void* __libc_calloc( size_t amount, size_t size );
+extern "C" void* __libc_realloc( void* pointer, size_t size );
+extern "C" void  __libc_free( void* pointer );
+extern "C" void* __libc_memalign( size_t alignment, size_t size );
+#endif
+
+// the flag must be accessible without the thread local storage itself allocating memory
+
+#if JUCE_GCC || JUCE_CLANG
+    #define REALTIME_TLS thread_local __attribute__(( tls_model( "initial-exec" )))
+#else
+    #define REALTIME_TLS thread_local
+#endif
+
+namespace
+{
+    REALTIME_TLS bool isRealtimeThread = false;
+    std::atomic<int> violations { 0 };
+
+    void reportViolation( const char* call )
+    {
+        if ( !isRealtimeThread ) {
+            return;
+        }
+        // unflag the thread while reporting as retrieving the backtrace allocates too
+
+        isRealtimeThread = false;
+
+        violations.fetch_add( 1 );
+
+        auto backtrace = juce::SystemStats::getStackBacktrace();
+        std::fprintf( stderr, "RealtimeGuard: %s invoked on the audio thread\n%s\n", call, backtrace.toRawUTF8());
+        std::fflush( stderr );
+
+        isRealtimeThread = true;
+    }
+
+    inline void* allocate( size_t size )
+    {
+#if JUCE_LINUX
+        return __libc_malloc( size == 0 ? 1 : size );
+#else
+        return std::malloc( size == 0 ? 1 : size );
+#endif
+    }
+
+    inline void deallocate( void* pointer )
+    {
+#if JUCE_LINUX
+        __libc_free( pointer );
+#else
+        std::free( pointer );
+#endif
+    }
+
+    // aligned memory must be released using deallocateAligned() (on Windows it can't be passed to free())
+
+    inline void* allocateAligned( size_t size, size_t alignment )
+    {
+        size = size == 0 ? 1 : size;
+#if JUCE_LINUX
+        return __libc_memalign( alignment, size );
+#elif JUCE_WINDOWS
+        return _aligned_malloc( size, alignment );
+#else
+        void* pointer = nullptr;
+        return posix_memalign( &pointer, std::max( alignment, sizeof( void* )), size ) == 0 ? pointer : nullptr;
+#endif
+    }
+
+    inline void deallocateAligned( void* pointer )
+    {
+#if JUCE_WINDOWS
+        _aligned_free( pointer );
+#else
+        deallocate( pointer );
+#endif
+    }
+}
+
+namespace RealtimeGuard
+{
+    ScopedRealtimeSection::ScopedRealtimeSection() : wasRealtimeThread( isRealtimeThread )
+    {
+        isRealtimeThread = true;
+    }
+
+    ScopedRealtimeSection::~ScopedRealtimeSection()
+    {
+        isRealtimeThread = wasRealtimeThread;
+    }
+
+    int getViolationCount()
+    {
+        return violations.load();
+    }
+}
+
+/* global operator new/delete replacements */
+
+void* operator new( std::size_t size )
+{
+    reportViolation( "operator new" );
+
+    if ( void* pointer = allocate( size )) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[]( std::size_t size )
+{
+    reportViolation( "operator new[]" );
+
+    if ( void* pointer = allocate( size )) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new( std::size_t size, const std::nothrow_t& ) noexcept
+{
+    reportViolation( "operator new" );
+    return allocate( size );
+}
+
+void* operator new[]( std::size_t size, const std::nothrow_t& ) noexcept
+{
+    reportViolation( "operator new[]" );
+    return allocate( size );
+}
+
+void* operator new( std::size_t size, std::align_val_t alignment )
+{
+    reportViolation( "operator new" );
+
+    if ( void* pointer = allocateAligned( size, static_cast<std::size_t>( alignment ))) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[]( std::size_t size, std::align_val_t alignment )
+{
+    reportViolation( "operator new[]" );
+
+    if ( void* pointer = allocateAligned( size, static_cast<std::size_t>( alignment ))) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new( std::size_t size, std::align_val_t alignment, const std::nothrow_t& ) noexcept
+{
+    reportViolation( "operator new" );
+    return allocateAligned( size, static_cast<std::size_t>( alignment ));
+}
+
+void* operator new[]( std::size_t size, std::align_val_t alignment, const std::nothrow_t& ) noexcept
+{
+    reportViolation( "operator new[]" );
+    return allocateAligned( size, static_cast<std::size_t>( alignment ));
+}
+
+void operator delete( void* pointer ) noexcept
+{
+    reportViolation( "operator delete" );
+    deallocate( pointer );
+}
+
+void operator delete[]( void* pointer ) noexcept
+{
+    reportViolation( "operator delete[]" );
+    deallocate( pointer );
+}
+
+void operator delete( void* pointer, std::size_t ) noexcept
+{
+    reportViolation( "operator delete" );
+    deallocate( pointer );
+}
+
+void operator delete[]( void* pointer, std::size_t ) noexcept
+{
+    reportViolation( "operator delete[]" );
+    deallocate( pointer );
+}
+
+void operator delete( void* pointer, const std::nothrow_t& ) noexcept
+{
+    reportViolation( "operator delete" );
+    deallocate( pointer );
+}
+
+void operator delete[]( void* pointer, const std::nothrow_t& ) noexcept
+{
+    reportViolation( "operator delete[]" );
+    deallocate( pointer );
+}
+
+void operator delete( void* pointer, std::align_val_t ) noexcept
+{
+    reportViolation( "operator delete" );
+    deallocateAligned( pointer );
+}
+
+void operator delete[]( void* pointer, std::align_val_t ) noexcept
+{
+    reportViolation( "operator delete[]" );
+    deallocateAligned( pointer );
+}
+
+void operator delete( void* pointer, std::size_t, std::align_val_t ) noexcept
+{
+    reportViolation( "operator delete" );
+    deallocateAligned( pointer );
+}
+
+void operator delete[]( void* pointer, std::size_t, std::align_val_t ) noexcept
+{
+    reportViolation( "operator delete[]" );
+    deallocateAligned( pointer );
+}
+
+void operator delete( void* pointer, std::align_val_t, const std::nothrow_t& ) noexcept
+{
+    reportViolation( "operator delete" );
+    deallocateAligned( pointer );
+}
+
+void operator delete[]( void* pointer, std::align_val_t, const std::nothrow_t& ) noexcept
+{
+    reportViolation( "operator delete[]" );
+    deallocateAligned( pointer );
+}
+
+/* C allocation and locking replacements (glibc only, other platforms are covered by the above) */
+
+#if JUCE_LINUX
+
+extern "C" void* malloc( size_t size )
+{
+    reportViolation( "malloc" );
+    return __libc_malloc( size );
+}
+
+extern "C" void* calloc( size_t amount, size_t size )
+{
+    reportViolation( "calloc" );
+    return __libc_calloc( amount, size );
+}
+
+extern "C" void* realloc( void* pointer, size_t size )
+{
+    reportViolation( "realloc" );
+    return __libc_realloc( pointer, size );
+}
+
+extern "C" void free( void* pointer )
+{
+    reportViolation( "free" );
+    __libc_free( pointer );
+}
+
+extern "C" int posix_memalign( void** pointer, size_t alignment, size_t size )
+{
+    reportViolation( "posix_memalign" );
+
+    // the alignment must be a power of two multiple of the pointer size
+
+    if ( alignment < sizeof( void* ) || ( alignment & ( alignment - 1 )) != 0 ) {
+        return EINVAL;
+    }
+    void* memory = __libc_memalign( alignment, size );
+
+    if ( memory == nullptr ) {
+        return ENOMEM;
+    }
+    *pointer = memory;
+    return 0;
+}
+
+extern "C" void* aligned_alloc( size_t alignment, size_t size )
+{
+    reportViolation( "aligned_alloc" );
+    return __libc_memalign( alignment, size );
+}
+
+extern "C" void* memalign( size_t alignment, size_t size )
+{
+    reportViolation( "memalign" );
+    return __libc_memalign( alignment, size );
+}
+
+extern "C" int pthread_mutex_lock( pthread_mutex_t* mutex )
+{
+    using LockFunction = int (*)( pthread_mutex_t* );
+    static auto nextLock = reinterpret_cast<LockFunction>( dlsym( RTLD_NEXT, "pthread_mutex_lock" ));
+
+    reportViolation( "pthread_mutex_lock" );
+    return nextLock( mutex );
+}
+
+#endif
+
+#else
+
+namespace RealtimeGuard
+{
+    ScopedRealtimeSection::ScopedRealtimeSection() : wasRealtimeThread( false ) {}
+    ScopedRealtimeSection::~ScopedRealtimeSection() {}
+
+    int getViolationCount()
+    {
+        return 0;
+    }
+}
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#ifndef DELIRION_RT_CHECKS
+#define DELIRION_RT_CHECKS 0
+#endif
+
+/**
+ * Development aid that detects calls that are not real-time safe on the audio thread.
+ *
+ * While a ScopedRealtimeSection is alive, the current thread is flagged as the audio thread
+ * and all invocations of the global operator new/delete (including their aligned variants, and on
+ * Linux also malloc/calloc/realloc/free, posix_memalign/aligned_alloc/memalign and pthread_mutex_lock)
+ * made from it are reported to stderr with a stack trace.
+ *
+ * Only compiled in when DELIRION_RT_CHECKS is enabled as the interception replaces
+ * the allocation functions for the whole process.
+ */
+namespace RealtimeGuard
+{
+    class ScopedRealtimeSection
+    {
+        public:
+            ScopedRealtimeSection();
+            ~ScopedRealtimeSection();
+
+        private:
+            bool wasRealtimeThread; // sections can be nested, e.g. when a test renders the processor
+    };
+
+    // the total amount of real-time safety violations detected since launch
+
+    int getViolationCount();
+}
+
+#if DELIRION_RT_CHECKS
+    #define REALTIME_SECTION() RealtimeGuard::ScopedRealtimeSection realtimeSection
+#else
+    #define REALTIME_SECTION()
+#endif
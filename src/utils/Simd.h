@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#ifndef DELIRION_SIMD_REPORT
+#define DELIRION_SIMD_REPORT 0
+#endif
+
+/**
+ * Runtime selection of the instruction set used by the hot kernels, so a single build (targeting the baseline
+ * x86-64 instruction set, e.g. SSE2) uses wider vectors on the hardware supporting these.
+ *
+ * Each kernel is written once and compiled into a variant per level: a variant is a function marked with one of the
+ * DELIRION_TARGET_* attributes calling the kernel, which is then inlined into (and thus compiled for) the variant.
+ * The level is determined once in prepareToPlay() after which each module selects its variants, so no dispatch
+ * takes place within the kernels.
+ *
+ * Only GCC and Clang support per function targets (on x86), other builds only offer LEVEL_BASELINE (e.g. the
+ * instruction set the build targets).
+ */
+namespace Simd
+{
+    enum Level { LEVEL_BASELINE = 0, LEVEL_AVX2, LEVEL_AVX512, NUM_LEVELS };
+
+#if ( defined( __GNUC__ ) || defined( __clang__ )) && ( defined( __x86_64__ ) || defined( __i386__ ))
+    #define DELIRION_SIMD_DISPATCH 1
+    #define DELIRION_TARGET_BASELINE __attribute__(( flatten ))
+    #define DELIRION_TARGET_AVX2     __attribute__(( target( "avx2,fma" ), flatten ))
+    #define DELIRION_TARGET_AVX512   __attribute__(( target( "avx512f,avx512vl,avx2,fma" ), flatten ))
+#else
+    #define DELIRION_SIMD_DISPATCH 0
+    #define DELIRION_TARGET_BASELINE
+    #define DELIRION_TARGET_AVX2
+    #define DELIRION_TARGET_AVX512
+#endif
+
+    inline bool isSupported( int level )
+    {
+#if DELIRION_SIMD_DISPATCH
+        bool hasAVX2 = juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3();
+
+        switch ( level ) {
+            case LEVEL_AVX2:
+                return hasAVX2;
+            case LEVEL_AVX512:
+                return hasAVX2 && juce::SystemStats::hasAVX512F() && juce::SystemStats::hasAVX512VL();
+            default:
+                return level == LEVEL_BASELINE;
+        }
+#else
+        return level == LEVEL_BASELINE;
+#endif
+    }
+
+    // the highest level supported by the current CPU
+
+    inline int detectLevel()
+    {
+        for ( int level = NUM_LEVELS - 1; level > LEVEL_BASELINE; --level ) {
+            if ( isSupported( level )) {
+                return level;
+            }
+        }
+        return LEVEL_BASELINE;
+    }
+
+    inline const char* getLevelName( int level )
+    {
+        switch ( level ) {
+            case LEVEL_AVX2:
+                return "AVX2";
+            case LEVEL_AVX512:
+                return "AVX-512";
+            default:
+                return DELIRION_SIMD_DISPATCH ? "SSE2" : "baseline";
+        }
+    }
+
+    // selects the variant of a kernel for given level
+
+    template <typename Kernel>
+    inline Kernel select( int level, Kernel baseline, Kernel avx2, Kernel avx512 )
+    {
+        switch ( level ) {
+            case LEVEL_AVX2:
+                return avx2;
+            case LEVEL_AVX512:
+                return avx512;
+            default:
+                return baseline;
+        }
+    }
+}
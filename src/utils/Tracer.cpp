@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "Tracer.h"
+
+static const int FLUSH_INTERVAL_MS = 100;
+
+/* constructor/destructor */
+
+Tracer::Tracer( const juce::String& name, int capacity ) : juce::Thread( "Delirion trace writer" ), fifo( capacity )
+{
+    events.resize( static_cast<size_t>( capacity ));
+
+    startTicks     = juce::Time::getHighResolutionTicks();
+    ticksPerSecond = juce::Time::getHighResolutionTicksPerSecond();
+
+    auto traceFile = juce::File::getSpecialLocation( juce::File::userDocumentsDirectory )
+                        .getChildFile( name + ".json" )
+                        .getNonexistentSibling();
+
+    outputStream = std::make_unique<juce::FileOutputStream>( traceFile );
+
+    if ( !outputStream->openedOk()) {
+        outputStream.reset();
+        return;
+    }
+    *outputStream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    *outputStream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"processBlock\"}}";
+
+    startThread( juce::Thread::Priority::background );
+}
+
+Tracer::~Tracer()
+{
+    stopThread( FLUSH_INTERVAL_MS * 10 );
+
+    if ( outputStream == nullptr ) {
+        return;
+    }
+    flush();
+
+    *outputStream << "\n]}\n";
+    outputStream->flush();
+}
+
+/* private methods */
+
+void Tracer::record( const char* name, char phase, int channel, juce::int64 ticks, const char* argName, double argValue )
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite( 1, start1, size1, start2, size2 );
+
+    if ( size1 + size2 == 0 ) {
+        // flushing thread could not keep up, drop the event rather than block the audio thread
+        droppedEvents.fetch_add( 1, std::memory_order_relaxed );
+        return;
+    }
+    auto& event = events[ static_cast<size_t>( size1 > 0 ? start1 : start2 )];
+
+    event.name     = name;
+    event.argName  = argName;
+    event.argValue = argValue;
+    event.ticks    = ticks;
+    event.channel  = channel;
+    event.phase    = phase;
+
+    fifo.finishedWrite( 1 );
+}
+
+void Tracer::run()
+{
+    while ( !threadShouldExit()) {
+        flush();
+        wait( FLUSH_INTERVAL_MS );
+    }
+}
+
+void Tracer::flush()
+{
+    if ( outputStream == nullptr ) {
+        return;
+    }
+
+    double ticksToMicroseconds = 1000000.0 / static_cast<double>( ticksPerSecond );
+    int start1, size1, start2, size2;
+    fifo.prepareToRead( fifo.getNumReady(), start1, size1, start2, size2 );
+
+    auto writeEvents = [ & ]( int start, int amount )
+    {
+        for ( int i = start; i < start + amount; ++i ) {
+            auto& event = events[ static_cast<size_t>( i )];
+            double timestamp = static_cast<double>( event.ticks - startTicks ) * ticksToMicroseconds;
+
+            juce::String json = ",\n{\"name\":\"" + juce::String( event.name ) + "\",\"ph\":\"" + juce::String::charToString( event.phase ) +
+                                "\",\"ts\":" + juce::String( timestamp, 3 ) + ",\"pid\":1,\"tid\":" + juce::String( event.channel + 1 );
+
+            if ( event.phase == 'i' ) {
+                json += ",\"s\":\"p\"";
+            }
+            if ( event.argName != nullptr ) {
+                json += ",\"args\":{\"" + juce::String( event.argName ) + "\":" + juce::String( event.argValue ) + "}";
+            }
+            *outputStream << json << "}";
+        }
+    };
+    writeEvents( start1, size1 );
+    writeEvents( start2, size2 );
+
+    fifo.finishedRead( size1 + size2 );
+
+    int dropped = droppedEvents.exchange( 0 );
+
+    if ( dropped > 0 ) {
+        double timestamp = static_cast<double>( juce::Time::getHighResolutionTicks() - startTicks ) * ticksToMicroseconds;
+        *outputStream << ",\n{\"name\":\"dropped events\",\"ph\":\"C\",\"ts\":" << juce::String( timestamp, 3 )
+                      << ",\"pid\":1,\"args\":{\"amount\":" << dropped << "}}";
+    }
+    outputStream->flush();
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <vector>
+
+#ifndef DELIRION_TRACING
+#define DELIRION_TRACING 0
+#endif
+
+/**
+ * Records begin/end/instant events into a preallocated ring buffer from the
+ * audio thread, while a background thread flushes the recorded events into
+ * a Chrome trace JSON file (viewable in chrome://tracing or ui.perfetto.dev)
+ *
+ * Only a single thread (the audio thread) should write events. Event names
+ * are not copied and must therefore be string literals.
+ */
+class Tracer : private juce::Thread
+{
+    public:
+        static const int DEFAULT_CAPACITY = 65536; // in events
+        static const int MAIN_TRACK       = -1;    // channel index for processor-wide events
+
+        Tracer( const juce::String& name, int capacity = DEFAULT_CAPACITY );
+        ~Tracer() override;
+
+        inline void begin( const char* name, int channel = MAIN_TRACK )
+        {
+            record( name, 'B', channel, juce::Time::getHighResolutionTicks(), nullptr, 0.0 );
+        }
+
+        inline void end( const char* name, int channel = MAIN_TRACK, const char* argName = nullptr, double argValue = 0.0 )
+        {
+            record( name, 'E', channel, juce::Time::getHighResolutionTicks(), argName, argValue );
+        }
+
+        inline void instant( const char* name, const char* argName = nullptr, double argValue = 0.0 )
+        {
+            record( name, 'i', MAIN_TRACK, juce::Time::getHighResolutionTicks(), argName, argValue );
+        }
+
+        // annotates the point in time by which the block starting at provided tick count should have been rendered
+
+        inline void deadline( juce::int64 blockStartTicks, int numSamples, double sampleRate )
+        {
+            double seconds = static_cast<double>( numSamples ) / sampleRate;
+            auto deadlineTicks = blockStartTicks + static_cast<juce::int64>( seconds * static_cast<double>( ticksPerSecond ));
+
+            record( "deadline", 'i', MAIN_TRACK, deadlineTicks, "samples", static_cast<double>( numSamples ));
+        }
+
+    private:
+        struct Event {
+            const char* name;
+            const char* argName;
+            double argValue;
+            juce::int64 ticks;
+            int channel;
+            char phase;
+        };
+
+        void record( const char* name, char phase, int channel, juce::int64 ticks, const char* argName, double argValue );
+        void run() override;
+        void flush();
+
+        juce::AbstractFifo fifo;
+        std::vector<Event> events;
+        std::atomic<int> droppedEvents { 0 };
+
+        std::unique_ptr<juce::FileOutputStream> outputStream;
+        juce::int64 startTicks;
+        juce::int64 ticksPerSecond;
+};
+
+/**
+ * Convenience macros so tracing compiles away entirely when DELIRION_TRACING is disabled
+ */
+#if DELIRION_TRACING
+    #define TRACE_BEGIN( tracer, ... )   ( tracer )->begin( __VA_ARGS__ )
+    #define TRACE_END( tracer, ... )     ( tracer )->end( __VA_ARGS__ )
+    #define TRACE_INSTANT( tracer, ... ) ( tracer )->instant( __VA_ARGS__ )
+    #define TRACE_DEADLINE( tracer, ... ) ( tracer )->deadline( __VA_ARGS__ )
+#else
+    #define TRACE_BEGIN( tracer, ... )
+    #define TRACE_END( tracer, ... )
+    #define TRACE_INSTANT( tracer, ... )
+    #define TRACE_DEADLINE( tracer, ... )
+#endif
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#ifndef DELIRION_WATCHDOG
+#define DELIRION_WATCHDOG 0
+#endif
+
+/**
+ * Measures the time spent rendering a block and compares it against
+ * the duration of the block (e.g. the deadline by which the host expects it
+ * to be rendered). Real-time safe.
+ */
+class Watchdog
+{
+    public:
+        Watchdog()
+        {
+            ticksPerSecond = static_cast<double>( juce::Time::getHighResolutionTicksPerSecond());
+        }
+
+        inline void start()
+        {
+            startTicks = juce::Time::getHighResolutionTicks();
+        }
+
+        /**
+         * invoke when done rendering the block started at the last start() invocation
+         * returns the load for the block, e.g. the ratio of the processing time relative
+         * to the time available for its amount of samples (a value above 1 equals an overrun)
+         */
+        inline double stop( int numSamples, double sampleRate )
+        {
+            double elapsed  = static_cast<double>( juce::Time::getHighResolutionTicks() - startTicks ) / ticksPerSecond;
+            double deadline = static_cast<double>( numSamples ) / sampleRate;
+            double load     = deadline > 0.0 ? elapsed / deadline : 0.0;
+
+            if ( load > peakLoad ) {
+                peakLoad = load;
+            }
+            if ( load > 1.0 ) {
+                ++overruns;
+            }
+            return load;
+        }
+
+        inline double getPeakLoad() const
+        {
+            return peakLoad;
+        }
+
+        inline int getOverruns() const
+        {
+            return overruns;
+        }
+
+    private:
+        juce::int64 startTicks = 0;
+        double ticksPerSecond;
+        double peakLoad = 0.0;
+        int overruns    = 0;
+};
@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "../src/PluginProcessor.h"
+#include "../src/utils/RealtimeGuard.h"
+#include "TestSignals.h"
+
+/**
+ * Drives the processor the way real hosts do: with irregular block sizes (including single sample and empty blocks),
+ * a play head following a script of transport starts, stops and jumps, tempo changes and ramps and time signature
+ * changes, a play head that disappears mid-session and repeated calls to prepareToPlay() with other block sizes
+ * and sample rates.
+ *
+ * Each block is handed to the processor in buffers sized to exactly its length, so reads beyond the block are caught
+ * when built with DELIRION_SANITIZERS. The output is checked for non-finite samples, excessive peaks and glitches
+ * (sample-to-sample steps no processing stage can produce from the sine input) and the worst-case time spent
+ * on a block is reported.
+ */
+class HostSimulationTests : public juce::UnitTest
+{
+    public:
+        HostSimulationTests() : juce::UnitTest( "Host simulation", "Delirion" ) {}
+
+        void runTest() override
+        {
+            Script transport = {
+                { 0.0, Cue::START },
+                { 1.0, Cue::JUMP, 30.0 }, // forwards, in between beats
+                { 2.0, Cue::TEMPO, 96.0 },
+                { 3.0, Cue::TEMPO_RAMP, 174.0, 2.0 },
+                { 5.5, Cue::JUMP, 0.0 },  // backwards, as when looping
+                { 6.0, Cue::TIME_SIGNATURE, 7.0 },
+                { 7.0, Cue::STOP },
+                { 7.5, Cue::START },
+                { 8.0, Cue::TEMPO_RAMP, 60.0, 1.5 }
+            };
+
+            Script missingPlayHead = {
+                { 0.0, Cue::DETACH_PLAY_HEAD },
+                { 3.0, Cue::ATTACH_PLAY_HEAD },
+                { 3.0, Cue::START },
+                { 4.0, Cue::TEMPO, 140.0 },
+                { 5.0, Cue::DETACH_PLAY_HEAD }, // while playing
+                { 7.0, Cue::ATTACH_PLAY_HEAD }
+            };
+
+            Script prepare = {
+                { 0.0, Cue::START },
+                { 2.0, Cue::PREPARE, 64.0 },
+                { 4.0, Cue::PREPARE, 4096.0 },
+                { 6.0, Cue::SAMPLE_RATE, 96000.0 },
+                { 8.0, Cue::SAMPLE_RATE, 22050.0 }
+            };
+
+            // the defaults (Post filter crossover, waveshaper and Freeverb) and each other mode, with all bands synced
+
+            Settings defaults;
+            Settings fiveBands = {
+                { Parameters::BAND_COUNT, 5.f }, { Parameters::CROSSOVER_MODE, 2.f }, { Parameters::REVERB_TYPE, 1.f },
+                { Parameters::REVERB_FREEZE, 1.f }, { Parameters::WET_DRY_MIX, 1.f }
+            };
+            Settings bitcrusher = {
+                { Parameters::CROSSOVER_MODE, 1.f }, { Parameters::DISTORTION_TYPE, 1.f }, { Parameters::REVERB_TYPE, 2.f },
+                { Parameters::LFO_WAVEFORM, 1.f }
+            };
+
+            simulate( "Transport",         defaults,   transport );
+            simulate( "Transport (bands)", fiveBands,  transport );
+            simulate( "Transport (FDN)",   bitcrusher, transport );
+
+            simulate( "Missing play head",         defaults,  missingPlayHead );
+            simulate( "Missing play head (bands)", fiveBands, missingPlayHead );
+
+            simulate( "Prepare",         defaults,   prepare );
+            simulate( "Prepare (bands)", fiveBands,  prepare );
+            simulate( "Prepare (FDN)",   bitcrusher, prepare );
+        }
+
+    private:
+        static constexpr double SIMULATED_DURATION = 10.0; // in seconds
+        static constexpr int BLOCK_SIZE  = 512;                // the maximum block size when starting the simulation
+        static constexpr int RANDOM_SEED = 0x686f7374;         // so each simulation renders the same block sizes
+
+        // the input is a sine at this frequency in the left channel and its octave in the right channel
+
+        static constexpr double INPUT_FREQUENCY = 110.0;
+        static constexpr float  INPUT_LEVEL     = 0.5f;
+
+        // the Doppler effects click where their read position crosses their write position (a step between two
+        // recorded input values, which can't exceed the peak-to-peak level of the input). Larger steps, output
+        // beyond +12 dBFS and silent runs (the output is never silent, as the input never is) are glitches
+
+        static constexpr float MAXIMUM_PEAK   = 4.f;
+        static constexpr float MAXIMUM_STEP   = INPUT_LEVEL * 2.f;
+        static constexpr int MAXIMUM_SILENT_RUN = 64; // in samples
+
+        struct Cue
+        {
+            enum Action { START, STOP, JUMP, TEMPO, TEMPO_RAMP, TIME_SIGNATURE, DETACH_PLAY_HEAD, ATTACH_PLAY_HEAD, PREPARE, SAMPLE_RATE };
+
+            double time; // in seconds of simulated audio
+            Action action;
+            double value    = 0.0; // the position (in seconds), tempo, numerator of the time signature, block size or sample rate
+            double duration = 0.0; // of a TEMPO_RAMP, in seconds
+        };
+
+        using Script   = std::vector<Cue>;
+        using Settings = std::vector<std::pair<juce::String, float>>;
+
+        class ScriptedPlayHead : public juce::AudioPlayHead
+        {
+            public:
+                juce::Optional<PositionInfo> getPosition() const override
+                {
+                    return position;
+                }
+
+                PositionInfo position;
+        };
+
+        // the properties of the output rendered during a simulation
+
+        struct OutputAnalysis
+        {
+            bool   isFinite        = true;
+            float  peak            = 0.f;
+            float  largestStep     = 0.f;
+            double largestStepTime = 0.0; // in seconds
+            int    longestSilence  = 0;   // in samples
+            double longestSilenceTime = 0.0;
+            int    unprocessedBlocks  = 0; // blocks left identical to their input
+
+            float previousSamples[ TestSignals::NUM_CHANNELS ] = {};
+            int   silentSamples  [ TestSignals::NUM_CHANNELS ] = {};
+            bool  hasPrevious    = false;
+            int   pendingLatency = 0; // samples that remain silent while the processor fills its latency
+
+            // invoked after each call to prepareToPlay(), no step is measured across it
+
+            void restart( int latency )
+            {
+                hasPrevious    = false;
+                pendingLatency = latency;
+
+                for ( int channel = 0; channel < TestSignals::NUM_CHANNELS; ++channel ) {
+                    silentSamples[ channel ] = 0;
+                }
+            }
+
+            void analyse( const juce::AudioBuffer<float>& input, const juce::AudioBuffer<float>& output, double time, double sampleRate )
+            {
+                int blockSize = output.getNumSamples();
+                bool isUnprocessed = blockSize > 0;
+
+                for ( int channel = 0; channel < TestSignals::NUM_CHANNELS; ++channel ) {
+                    const float* samples = output.getReadPointer( channel );
+                    float previous = hasPrevious ? previousSamples[ channel ] : samples[ 0 ];
+
+                    for ( int i = 0; i < blockSize; ++i ) {
+                        float sample = samples[ i ];
+                        isUnprocessed = isUnprocessed && juce::exactlyEqual( sample, input.getSample( channel, i ));
+
+                        if ( !std::isfinite( sample )) {
+                            isFinite = false;
+                            continue;
+                        }
+                        peak = std::max( peak, std::abs( sample ));
+
+                        float step = std::abs( sample - previous );
+                        previous = sample;
+
+                        if ( step > largestStep ) {
+                            largestStep     = step;
+                            largestStepTime = time + i / sampleRate;
+                        }
+
+                        if ( i < pendingLatency ) {
+                            continue;
+                        }
+                        silentSamples[ channel ] = juce::exactlyEqual( sample, 0.f ) ? silentSamples[ channel ] + 1 : 0;
+
+                        if ( silentSamples[ channel ] > longestSilence ) {
+                            longestSilence     = silentSamples[ channel ];
+                            longestSilenceTime = time + i / sampleRate;
+                        }
+                    }
+                    previousSamples[ channel ] = previous;
+                }
+                hasPrevious    = hasPrevious || blockSize > 0;
+                pendingLatency = std::max( 0, pendingLatency - blockSize );
+
+                if ( isUnprocessed ) {
+                    ++unprocessedBlocks;
+                }
+            }
+        };
+
+        void simulate( const juce::String& description, const Settings& settings, const Script& script )
+        {
+            beginTest( description );
+
+            auto processor = std::make_unique<AudioPluginAudioProcessor>();
+
+            for ( const auto& setting : settings ) {
+                auto* parameter = processor->parameters.getParameter( setting.first );
+                parameter->setValueNotifyingHost( parameter->convertTo0to1( setting.second ));
+            }
+
+            double sampleRate = TestSignals::SAMPLE_RATE;
+            int maximumBlockSize = BLOCK_SIZE;
+
+            processor->prepareToPlay( sampleRate, maximumBlockSize );
+
+            OutputAnalysis analysis;
+            analysis.restart( processor->getLatencySamples());
+
+            ScriptedPlayHead playHead;
+            processor->setPlayHead( &playHead );
+
+            juce::Random random( RANDOM_SEED );
+            juce::MidiBuffer midiMessages;
+
+            bool   isPlaying  = false;
+            double tempo      = 120.0;
+            int    numerator  = 4;
+            double position   = 0.0; // of the transport, in seconds
+            double rampStart  = 0.0;
+            double rampEnd    = 0.0;
+            double rampFrom   = tempo;
+            double rampTo     = tempo;
+            double elapsed    = 0.0; // the duration of the simulated audio, in seconds
+            double inputPhase = 0.0;
+            size_t nextCue    = 0;
+
+            double worstDuration  = 0.0; // in microseconds
+            int    worstBlockSize = 0;
+            double worstDeadline  = 0.0;
+
+            int violations = RealtimeGuard::getViolationCount();
+
+            while ( elapsed < SIMULATED_DURATION )
+            {
+                for ( ; nextCue < script.size() && script[ nextCue ].time <= elapsed; ++nextCue ) {
+                    const auto& cue = script[ nextCue ];
+
+                    switch ( cue.action ) {
+                        case Cue::START:            isPlaying = true;  break;
+                        case Cue::STOP:             isPlaying = false; break;
+                        case Cue::JUMP:             position = cue.value; break;
+                        case Cue::TEMPO:            tempo = rampTo = cue.value; rampEnd = elapsed; break;
+                        case Cue::TIME_SIGNATURE:   numerator = static_cast<int>( cue.value ); break;
+                        case Cue::DETACH_PLAY_HEAD: processor->setPlayHead( nullptr ); break;
+                        case Cue::ATTACH_PLAY_HEAD: processor->setPlayHead( &playHead ); break;
+
+                        case Cue::TEMPO_RAMP:
+                            rampStart = elapsed;
+                            rampEnd   = elapsed + cue.duration;
+                            rampFrom  = tempo;
+                            rampTo    = cue.value;
+                            break;
+
+                        case Cue::PREPARE:
+                        case Cue::SAMPLE_RATE:
+                            if ( cue.action == Cue::PREPARE ) {
+                                maximumBlockSize = static_cast<int>( cue.value );
+                            } else {
+                                sampleRate = cue.value;
+                            }
+                            processor->releaseResources();
+                            processor->prepareToPlay( sampleRate, maximumBlockSize );
+                            analysis.restart( processor->getLatencySamples());
+                            break;
+                    }
+                }
+
+                if ( elapsed < rampEnd ) {
+                    tempo = rampFrom + ( rampTo - rampFrom ) * ( elapsed - rampStart ) / ( rampEnd - rampStart );
+                } else {
+                    tempo = rampTo;
+                }
+
+                juce::AudioPlayHead::TimeSignature timeSignature;
+                timeSignature.numerator = numerator;
+
+                playHead.position.setIsPlaying( isPlaying );
+                playHead.position.setBpm( tempo );
+                playHead.position.setTimeSignature( timeSignature );
+                playHead.position.setTimeInSeconds( position );
+                playHead.position.setTimeInSamples( static_cast<juce::int64>( position * sampleRate ));
+                playHead.position.setPpqPosition( position * tempo / 60.0 );
+
+                // each channel is allocated separately to the exact length of the block (the processor
+                // can't refer to a null channel, so an empty block is allocated a single sample)
+
+                int blockSize = getNextBlockSize( random, maximumBlockSize );
+
+                std::vector<std::vector<float>> channels( TestSignals::NUM_CHANNELS, std::vector<float>( static_cast<size_t>( std::max( 1, blockSize ))));
+                float* channelPointers[ TestSignals::NUM_CHANNELS ];
+
+                for ( int channel = 0; channel < TestSignals::NUM_CHANNELS; ++channel ) {
+                    auto& samples = channels[ static_cast<size_t>( channel )];
+
+                    for ( int i = 0; i < blockSize; ++i ) {
+                        double phase = inputPhase + juce::MathConstants<double>::twoPi * INPUT_FREQUENCY * i / sampleRate;
+                        samples[ static_cast<size_t>( i )] = static_cast<float>( std::sin( phase * ( channel + 1 ))) * INPUT_LEVEL;
+                    }
+                    channelPointers[ channel ] = samples.data();
+                }
+                juce::AudioBuffer<float> buffer( channelPointers, TestSignals::NUM_CHANNELS, blockSize );
+                juce::AudioBuffer<float> input( buffer );
+
+                auto startTicks = juce::Time::getHighResolutionTicks();
+
+                processor->processBlock( buffer, midiMessages );
+
+                double duration = juce::Time::highResolutionTicksToSeconds( juce::Time::getHighResolutionTicks() - startTicks ) * 1e6;
+
+                if ( duration > worstDuration ) {
+                    worstDuration  = duration;
+                    worstBlockSize = blockSize;
+                    worstDeadline  = blockSize / sampleRate * 1e6;
+                }
+                analysis.analyse( input, buffer, elapsed, sampleRate );
+
+                double blockDuration = blockSize / sampleRate;
+
+                inputPhase = std::fmod( inputPhase + juce::MathConstants<double>::twoPi * INPUT_FREQUENCY * blockDuration, juce::MathConstants<double>::twoPi );
+                elapsed   += blockDuration;
+
+                if ( isPlaying ) {
+                    position += blockDuration;
+                }
+            }
+            processor->setPlayHead( nullptr );
+
+            // the worst-case time spent on a block is reported rather than enforced, as a single block is easily
+            // delayed by the machine running the test (the median time is held to a budget by the render tests)
+
+            double worstLoad = worstDeadline > 0.0 ? worstDuration / worstDeadline * 100.0 : 0.0;
+
+            logMessage( description + ": worst case " + juce::String( worstDuration, 1 ) + " us for a block of " + juce::String( worstBlockSize )
+                        + " samples (" + juce::String( worstLoad, 1 ) + "% of its deadline), largest step " + juce::String( analysis.largestStep, 3 )
+                        + " at " + juce::String( analysis.largestStepTime, 3 ) + " s, peak " + juce::String( analysis.peak, 3 ));
+
+            expect( analysis.isFinite, description + " rendered samples that are not finite" );
+            expect( analysis.peak <= MAXIMUM_PEAK, description + " peaked at " + juce::String( analysis.peak, 3 ));
+            expect( analysis.largestStep <= MAXIMUM_STEP,
+                    description + " glitched at " + juce::String( analysis.largestStepTime, 3 ) + " s (a step of " + juce::String( analysis.largestStep, 3 ) + ")" );
+            expect( analysis.longestSilence <= MAXIMUM_SILENT_RUN,
+                    description + " dropped out at " + juce::String( analysis.longestSilenceTime, 3 ) + " s (" + juce::String( analysis.longestSilence ) + " silent samples)" );
+            expectEquals( analysis.unprocessedBlocks, 0, description + " left blocks unprocessed" );
+
+            // only counted when built with DELIRION_RT_CHECKS (each violation is reported to stderr along with its stack trace)
+
+            expectEquals( RealtimeGuard::getViolationCount() - violations, 0,
+                          description + " allocated memory or locked a mutex on the audio thread" );
+        }
+
+        // hosts mostly render their buffer size but split blocks around automation and loop points and can
+        // send empty blocks, the block size never exceeds the size the processor was prepared for
+
+        static int getNextBlockSize( juce::Random& random, int maximumBlockSize )
+        {
+            switch ( random.nextInt( 4 )) {
+                default:
+                case 0:
+                case 1:
+                    return maximumBlockSize;
+                case 2:
+                    return random.nextInt( std::min( 16, maximumBlockSize ) + 1 );
+                case 3:
+                    return random.nextInt( maximumBlockSize + 1 );
+            }
+        }
+};
+
+static HostSimulationTests hostSimulationTests;
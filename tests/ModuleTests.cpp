@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "RenderTest.h"
+#include "../src/modules/bitcrusher/Bitcrusher.h"
+#include "../src/modules/doppler/DopplerEffect.h"
+#include "../src/modules/filter/Crossover.h"
+#include "../src/modules/filter/FilterBank.h"
+#include "../src/modules/filter/LinearPhaseCrossover.h"
+#include "../src/modules/reverb/ConvolutionReverb.h"
+#include "../src/modules/reverb/FdnReverb.h"
+#include "../src/modules/reverb/Reverb.h"
+#include "../src/modules/waveshaper/WaveShaper.h"
+
+namespace
+{
+    // the probe is split into three bands, rendered as the channels of the output
+
+    const int NUM_BANDS = 3;
+    const float SPLIT_FREQUENCIES[ NUM_BANDS - 1 ] = { 200.f, 2000.f };
+}
+
+class CrossoverTests : public RenderTest
+{
+    public:
+        CrossoverTests() : RenderTest( "Crossovers" ) {}
+
+        void runTest() override
+        {
+            beginTest( "Post filter" );
+
+            expectRendering( "module_post_filter", 1, NUM_BANDS, []( bool isOffline ) -> BlockRenderer
+            {
+                auto filterBank = std::make_shared<FilterBank>();
+                auto state      = std::make_shared<FilterBank::State>();
+
+                juce::IIRCoefficients coefficients[ NUM_BANDS ] = {
+                    juce::IIRCoefficients::makeLowPass ( TestSignals::SAMPLE_RATE, SPLIT_FREQUENCIES[ 0 ]),
+                    juce::IIRCoefficients::makeBandPass( TestSignals::SAMPLE_RATE, std::sqrt( SPLIT_FREQUENCIES[ 0 ] * SPLIT_FREQUENCIES[ 1 ]), 1.0 ),
+                    juce::IIRCoefficients::makeHighPass( TestSignals::SAMPLE_RATE, SPLIT_FREQUENCIES[ 1 ])
+                };
+                filterBank->setCoefficients( coefficients, NUM_BANDS );
+                filterBank->setSimdLevel( getSimdLevel( isOffline ));
+
+                return [ filterBank, state ]( const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output )
+                {
+                    for ( int band = 1; band < NUM_BANDS; ++band ) {
+                        output.copyFrom( band, 0, input, 0, 0, input.getNumSamples());
+                    }
+                    filterBank->process( *state, output.getArrayOfWritePointers(), NUM_BANDS, output.getNumSamples());
+                };
+            });
+
+            beginTest( "Linkwitz-Riley" );
+
+            expectRendering( "module_linkwitz_riley", 1, NUM_BANDS, []( bool isOffline ) -> BlockRenderer
+            {
+                auto crossover = std::make_shared<Crossover>();
+                auto state     = std::make_shared<Crossover::State>();
+
+                crossover->setFrequencies( SPLIT_FREQUENCIES, NUM_BANDS - 1, TestSignals::SAMPLE_RATE );
+                crossover->setSimdLevel( getSimdLevel( isOffline ));
+
+                return [ crossover, state ]( const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output )
+                {
+                    crossover->split( *state, input.getReadPointer( 0 ), output.getArrayOfWritePointers(), NUM_BANDS, output.getNumSamples());
+                };
+            });
+
+            beginTest( "Linear phase" );
+
+            expectRendering( "module_linear_phase", 1, NUM_BANDS, []( bool ) -> BlockRenderer
+            {
+                auto crossover = std::make_shared<LinearPhaseCrossover>( TestSignals::SAMPLE_RATE );
+                auto state     = std::make_shared<LinearPhaseCrossover::State>( TestSignals::SAMPLE_RATE );
+                auto dry       = std::make_shared<std::vector<float>>( BLOCK_SIZE ); // receives the delayed input
+
+                crossover->setFrequencies( SPLIT_FREQUENCIES, NUM_BANDS - 1 );
+
+                return [ crossover, state, dry ]( const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output )
+                {
+                    std::copy_n( input.getReadPointer( 0 ), input.getNumSamples(), dry->data());
+                    crossover->split( *state, dry->data(), output.getArrayOfWritePointers(), NUM_BANDS, output.getNumSamples());
+                };
+            });
+        }
+};
+
+class ReverbTests : public RenderTest
+{
+    public:
+        ReverbTests() : RenderTest( "Reverbs" ) {}
+
+        void runTest() override
+        {
+            beginTest( "Freeverb" );
+
+            expectRendering( "module_freeverb", 1, 1, []( bool isOffline ) -> BlockRenderer
+            {
+                auto reverb = std::make_shared<Reverb<float>>( TestSignals::SAMPLE_RATE, Parameters::Config::REVERB_WIDTH_DEF, Parameters::Config::REVERB_SIZE_DEF );
+                auto memory = std::make_shared<std::vector<float>>( reverb->getMemorySize(), 0.f );
+
+                reverb->allocate( memory->data());
+                reverb->setWet( 1.f );
+                reverb->setDry( 0.f );
+                reverb->setSimdLevel( getSimdLevel( isOffline ));
+
+                return [ reverb, memory ]( const juce::AudioBuffer<float>&, juce::AudioBuffer<float>& output )
+                {
+                    reverb->apply( output.getWritePointer( 0 ), output.getNumSamples());
+                };
+            });
+
+            beginTest( "Convolution" );
+
+            expectRendering( "module_convolution", TestSignals::NUM_CHANNELS, TestSignals::NUM_CHANNELS, []( bool isOffline ) -> BlockRenderer
+            {
+                auto reverb = std::make_shared<ConvolutionReverb>( TestSignals::SAMPLE_RATE, TestSignals::NUM_CHANNELS );
+
+                reverb->setImpulseResponse( reverb->createDefaultImpulseResponse( Parameters::Config::REVERB_DECAY_DEF ));
+                reverb->setWet( 1.f );
+                reverb->setDry( 0.f );
+                reverb->setNonRealtime( isOffline );
+
+                return [ reverb ]( const juce::AudioBuffer<float>&, juce::AudioBuffer<float>& output )
+                {
+                    for ( int channel = 0; channel < output.getNumChannels(); ++channel ) {
+                        reverb->apply( channel, output.getWritePointer( channel ), output.getNumSamples());
+                    }
+                };
+            });
+
+            beginTest( "FDN" );
+
+            expectRendering( "module_fdn", TestSignals::NUM_CHANNELS, TestSignals::NUM_CHANNELS, []( bool isOffline ) -> BlockRenderer
+            {
+                auto reverb = std::make_shared<FdnReverb>( TestSignals::SAMPLE_RATE, Parameters::Config::REVERB_DECAY_DEF, Parameters::Config::REVERB_DAMP_DEF );
+
+                reverb->setWet( 1.f );
+                reverb->setDry( 0.f );
+                reverb->setSimdLevel( getSimdLevel( isOffline ));
+
+                return [ reverb ]( const juce::AudioBuffer<float>&, juce::AudioBuffer<float>& output )
+                {
+                    // the network renders at most PRE_DELAY samples at a time
+
+                    for ( int offset = 0; offset < output.getNumSamples(); offset += FdnReverb::PRE_DELAY ) {
+                        int length = std::min( FdnReverb::PRE_DELAY, output.getNumSamples() - offset );
+
+                        for ( int channel = 0; channel < output.getNumChannels(); ++channel ) {
+                            reverb->apply( channel, output.getWritePointer( channel, offset ), length );
+                        }
+                        reverb->advance( length );
+                    }
+                };
+            });
+        }
+};
+
+class DistortionTests : public RenderTest
+{
+    public:
+        DistortionTests() : RenderTest( "Distortion" ) {}
+
+        void runTest() override
+        {
+            beginTest( "Waveshaper" );
+
+            expectRendering( "module_waveshaper", 1, 1, []( bool isOffline ) -> BlockRenderer
+            {
+                auto waveShaper = std::make_shared<WaveShaper<float>>( Parameters::Config::DISTORTION_AMT_DEF, Parameters::Config::DISTORTION_WET_DEF );
+                waveShaper->setSimdLevel( getSimdLevel( isOffline ));
+
+                return [ waveShaper ]( const juce::AudioBuffer<float>&, juce::AudioBuffer<float>& output )
+                {
+                    waveShaper->apply( output.getWritePointer( 0 ), output.getNumSamples());
+                };
+            });
+
+            beginTest( "Bitcrusher" );
+
+            expectRendering( "module_bitcrusher", 1, 1, []( bool ) -> BlockRenderer
+            {
+                auto bitCrusher = std::make_shared<BitCrusher>( Parameters::Config::DISTORTION_AMT_DEF, 1.f, Parameters::Config::DISTORTION_WET_DEF, 1 );
+                bitCrusher->setDownsampling( 0.5f );
+
+                return [ bitCrusher ]( const juce::AudioBuffer<float>&, juce::AudioBuffer<float>& output )
+                {
+                    bitCrusher->apply( 0, output.getWritePointer( 0 ), output.getNumSamples());
+                };
+            });
+        }
+};
+
+class DopplerTests : public RenderTest
+{
+    public:
+        DopplerTests() : RenderTest( "Doppler" ) {}
+
+        void runTest() override
+        {
+            beginTest( "Free running" );
+
+            expectRendering( "module_doppler_free", 1, 1, []( bool ) -> BlockRenderer
+            {
+                return createRenderer( 0.5f, false, false );
+            });
+
+            beginTest( "Synced inverted" );
+
+            expectRendering( "module_doppler_synced_inverted", 1, 1, []( bool ) -> BlockRenderer
+            {
+                return createRenderer( 1.f, true, true );
+            });
+
+            beginTest( "Synced read lag" );
+
+            for ( double tempo : { 60.0, 120.0, 174.0 }) {
+                for ( float speed : { 0.f, 0.5f, 1.f }) {
+                    expectContinuousLag( tempo, speed );
+                }
+            }
+        }
+
+    private:
+        static constexpr double TEMPO = 120.0; // so the synced effect realigns within the probe
+
+        static BlockRenderer createRenderer( float speed, bool invert, bool sync )
+        {
+            auto doppler = std::make_shared<DopplerEffect<float>>( TestSignals::SAMPLE_RATE, BLOCK_SIZE );
+
+            doppler->setProperties( speed, invert, sync );
+            doppler->updateTempo( TEMPO, 4, 4 );
+
+            int recordSize = doppler->getRequiredRecordSize();
+            auto memory    = std::make_shared<std::vector<float>>( doppler->getMemorySize( recordSize ), 0.f );
+
+            doppler->allocate( memory->data(), recordSize );
+
+            return [ doppler, memory ]( const juce::AudioBuffer<float>&, juce::AudioBuffer<float>& output )
+            {
+                doppler->apply( output.getWritePointer( 0 ), output.getNumSamples());
+            };
+        }
+
+        static constexpr double LAG_DURATION = 30.0; // in seconds, spanning many cycles of the recording
+        static constexpr double MAX_LAG_STEP = 16.0; // in samples, between consecutive samples
+        static constexpr double DC_OFFSET_FILTER = static_cast<double>( 0.995f ); // of the effect, reverted to recover its reads
+
+        // the input holds the time at which each sample is recorded, so the output (once its DC offset filter has
+        // been reverted) holds the time at which the samples it read were recorded. The distance between both (the lag)
+        // must remain within the recording and change gradually, as it jumps by the size of the recording when the
+        // read position crosses the write position (reading history that has already been overwritten)
+
+        void expectContinuousLag( double tempo, float speed )
+        {
+            DopplerEffect<double> doppler( TestSignals::SAMPLE_RATE, BLOCK_SIZE );
+
+            doppler.setProperties( speed, true, true );
+            doppler.updateTempo( tempo, 4, 4 );
+
+            int recordSize = doppler.getRequiredRecordSize();
+            std::vector<float> memory( doppler.getMemorySize( recordSize ), 0.f );
+            doppler.allocate( memory.data(), recordSize );
+
+            std::vector<double> block( BLOCK_SIZE );
+            int numBlocks = static_cast<int>( LAG_DURATION * TestSignals::SAMPLE_RATE ) / BLOCK_SIZE;
+
+            double time = 0.0, readTime = 0.0, previousOutput = 0.0;
+            double minLag = std::numeric_limits<double>::max(), maxLag = 0.0, maxLagStep = 0.0, previousLag = 0.0;
+
+            for ( int i = 0; i < numBlocks; ++i ) {
+                for ( auto& sample : block ) {
+                    sample = time++;
+                }
+                doppler.apply( block.data(), BLOCK_SIZE );
+
+                for ( int j = 0; j < BLOCK_SIZE; ++j ) {
+                    readTime += block[ static_cast<size_t>( j )] - DC_OFFSET_FILTER * previousOutput;
+                    previousOutput = block[ static_cast<size_t>( j )];
+
+                    double lag = ( time - BLOCK_SIZE + j ) - readTime;
+
+                    if ( i > 0 || j > 0 ) {
+                        maxLagStep = std::max( maxLagStep, std::abs( lag - previousLag ));
+                    }
+                    minLag = std::min( minLag, lag );
+                    maxLag = std::max( maxLag, lag );
+                    previousLag = lag;
+                }
+            }
+            juce::String description = juce::String( tempo ) + " BPM at speed " + juce::String( speed );
+
+            expectGreaterOrEqual( minLag, 0.0, description + " read ahead of the write position" );
+            expectLessOrEqual( maxLag, static_cast<double>( recordSize ), description + " read beyond the recording" );
+            expectLessOrEqual( maxLagStep, MAX_LAG_STEP, description + " read overwritten history" );
+        }
+};
+
+static CrossoverTests crossoverTests;
+static ReverbTests reverbTests;
+static DistortionTests distortionTests;
+static DopplerTests dopplerTests;
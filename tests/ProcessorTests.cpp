@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "RenderTest.h"
+#include "../src/PluginProcessor.h"
+
+class ProcessorTests : public RenderTest
+{
+    public:
+        ProcessorTests() : RenderTest( "Processor" ) {}
+
+        void runTest() override
+        {
+            // each crossover mode (with the defaults: the waveshaper and Freeverb)
+
+            expectPreset( "Post filter",    "processor_post_filter",    {});
+            expectPreset( "Linkwitz-Riley", "processor_linkwitz_riley", {{ Parameters::CROSSOVER_MODE, 1.f }});
+            expectPreset( "Linear phase",   "processor_linear_phase",   {{ Parameters::CROSSOVER_MODE, 2.f }});
+
+            // each distortion type, a sample may be rounded onto the neighbouring step of the bitcrusher (at 8 bits)
+
+            expectPreset( "Bitcrusher", "processor_bitcrusher", {{ Parameters::DISTORTION_TYPE, 1.f }, { Parameters::DISTORTION_RATE, 0.5f }}, 4e-3f );
+
+            // each reverb type, which is only audible when frozen
+
+            expectPreset( "Freeverb freeze",    "processor_freeverb_freeze",    {{ Parameters::REVERB_FREEZE, 1.f }});
+            expectPreset( "Convolution freeze", "processor_convolution_freeze", {{ Parameters::REVERB_FREEZE, 1.f }, { Parameters::REVERB_TYPE, 1.f }});
+            expectPreset( "FDN freeze",         "processor_fdn_freeze",         {{ Parameters::REVERB_FREEZE, 1.f }, { Parameters::REVERB_TYPE, 2.f }});
+
+            // interpolated mid bands with free running, unlinked LFOs (the random waveform is not deterministic)
+
+            expectPreset( "Five bands", "processor_five_bands", {
+                { Parameters::BAND_COUNT, 5.f }, { Parameters::WET_DRY_MIX, 0.5f }, { Parameters::BEAT_SYNC, 0.f },
+                { Parameters::LFO_WAVEFORM, 1.f }, { Parameters::LOW_LFO_ODD, 0.3f }, { Parameters::HI_LFO_EVEN, 0.6f },
+                { Parameters::HI_LFO_LINK, 0.f }
+            });
+
+            expectTileSizes();
+        }
+
+    private:
+        using Settings = std::vector<std::pair<juce::String, float>>;
+
+        static const int BOUNCE_BLOCK_SIZE = 8192; // as provided by hosts when bouncing offline
+        static const int MIN_TILE_SIZE     = 32;
+
+        // renders large blocks in tiles of decreasing size (from Parameters::Config::TILE_SIZE, which can be raised
+        // using DELIRION_TILE_SIZE to measure larger tiles) and logs the throughput of each, as it depends on the
+        // caches of the machine. The output must not depend on the tile size
+
+        void expectTileSizes()
+        {
+            beginTest( "Tile sizes" );
+
+            juce::AudioBuffer<float> reference;
+            double referenceDuration = 0.0;
+
+            for ( int tileSize = Parameters::Config::TILE_SIZE; tileSize >= MIN_TILE_SIZE; tileSize /= 2 ) {
+                auto processor = std::make_shared<AudioPluginAudioProcessor>();
+                processor->setNonRealtime( true );
+                processor->setMaxTileSize( tileSize );
+                processor->prepareToPlay( TestSignals::SAMPLE_RATE, BOUNCE_BLOCK_SIZE );
+
+                juce::AudioBuffer<float> output;
+                double duration = measureThroughput( TestSignals::NUM_CHANNELS, TestSignals::NUM_CHANNELS,
+                                                     [ processor ]( const juce::AudioBuffer<float>&, juce::AudioBuffer<float>& block )
+                {
+                    juce::MidiBuffer midiMessages;
+                    processor->processBlock( block, midiMessages );
+                }, BOUNCE_BLOCK_SIZE, output );
+
+                if ( tileSize == Parameters::Config::TILE_SIZE ) {
+                    reference = output;
+                    referenceDuration = duration;
+                }
+                logMessage( "tiles of " + juce::String( tileSize ) + " samples: " + juce::String( duration, 1 ) + " ns per sample ("
+                            + juce::String( duration / referenceDuration, 2 ) + "x the time of " + juce::String( Parameters::Config::TILE_SIZE ) + ")" );
+
+                float maxDeviation = 0.f;
+
+                for ( int channel = 0; channel < output.getNumChannels(); ++channel ) {
+                    for ( int i = 0; i < output.getNumSamples(); ++i ) {
+                        maxDeviation = std::max( maxDeviation, std::abs( output.getSample( channel, i ) - reference.getSample( channel, i )));
+                    }
+                }
+                expect( maxDeviation <= TOLERANCE, "tiles of " + juce::String( tileSize ) + " samples deviate " + juce::String( maxDeviation ) + " from tiles of "
+                        + juce::String( Parameters::Config::TILE_SIZE ));
+            }
+        }
+
+        void expectPreset( const juce::String& description, const juce::String& renderingName, const Settings& settings, float tolerance = TOLERANCE )
+        {
+            beginTest( description );
+
+            expectRendering( renderingName, TestSignals::NUM_CHANNELS, TestSignals::NUM_CHANNELS, [ settings ]( bool isOffline ) -> BlockRenderer
+            {
+                auto processor = std::make_shared<AudioPluginAudioProcessor>();
+
+                for ( const auto& setting : settings ) {
+                    auto* parameter = processor->parameters.getParameter( setting.first );
+                    parameter->setValueNotifyingHost( parameter->convertTo0to1( setting.second ));
+                }
+                processor->setNonRealtime( isOffline );
+                processor->setMaxSimdLevel( getSimdLevel( isOffline ));
+                processor->prepareToPlay( TestSignals::SAMPLE_RATE, BLOCK_SIZE );
+
+                return [ processor ]( const juce::AudioBuffer<float>&, juce::AudioBuffer<float>& output )
+                {
+                    juce::MidiBuffer midiMessages;
+                    processor->processBlock( output, midiMessages );
+                };
+            }, tolerance );
+        }
+};
+
+static ProcessorTests processorTests;
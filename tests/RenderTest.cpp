@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "RenderTest.h"
+#include "../src/utils/RealtimeGuard.h"
+#include "../src/utils/Simd.h"
+#include <limits>
+#include <numeric>
+
+bool RenderTest::updateReferences = false;
+bool RenderTest::updateBudgets    = false;
+bool RenderTest::checkDeadline    = false;
+
+RenderTest::RenderTest( const juce::String& testName ) : juce::UnitTest( testName, "Delirion" )
+{
+    // nowt
+}
+
+juce::String RenderTest::getMachineClass()
+{
+#if JUCE_INTEL && JUCE_64BIT
+    juce::String architecture( "x86_64" );
+#elif JUCE_INTEL
+    juce::String architecture( "x86" );
+#elif JUCE_ARM && JUCE_64BIT
+    juce::String architecture( "arm64" );
+#elif JUCE_ARM
+    juce::String architecture( "arm" );
+#else
+    juce::String architecture( "unknown" );
+#endif
+
+#if JUCE_DEBUG
+    juce::String build( "debug" );
+#else
+    juce::String build( "release" );
+#endif
+
+    juce::String level = juce::String( Simd::getLevelName( Simd::detectLevel())).toLowerCase().removeCharacters( "-" );
+
+    return architecture + "-" + level + "-" + build;
+}
+
+/* protected methods */
+
+int RenderTest::getSimdLevel( bool isOffline )
+{
+    return isOffline ? Simd::LEVEL_BASELINE : Simd::detectLevel();
+}
+
+void RenderTest::expectRendering( const juce::String& renderingName, int numInputChannels, int numOutputChannels,
+                                  const RendererFactory& createRenderer, float tolerance )
+{
+    int violations = RealtimeGuard::getViolationCount();
+
+    expectMatchesReference( renderingName, render( numInputChannels, numOutputChannels, createRenderer( true )), tolerance );
+
+    std::vector<double> blockDurations;
+    auto renderBlock = createRenderer( false );
+
+    for ( int run = 0; run < MEASURED_RUNS; ++run ) {
+        render( numInputChannels, numOutputChannels, renderBlock, &blockDurations );
+    }
+    expectWithinBudget( renderingName, std::move( blockDurations ));
+
+    // only counted when built with DELIRION_RT_CHECKS (each violation is reported to stderr along with its stack trace)
+
+    expectEquals( RealtimeGuard::getViolationCount() - violations, 0,
+                  renderingName + " allocated memory or locked a mutex on the audio thread" );
+}
+
+double RenderTest::measureThroughput( int numInputChannels, int numOutputChannels, const BlockRenderer& renderBlock,
+                                      int blockSize, juce::AudioBuffer<float>& output )
+{
+    double fastestRun = std::numeric_limits<double>::max();
+
+    for ( int run = 0; run < MEASURED_RUNS; ++run ) {
+        std::vector<double> blockDurations;
+        auto rendering = render( numInputChannels, numOutputChannels, renderBlock, &blockDurations, blockSize );
+
+        if ( run == 0 ) {
+            output = std::move( rendering );
+        }
+        fastestRun = std::min( fastestRun, std::accumulate( blockDurations.begin(), blockDurations.end(), 0.0 ));
+    }
+    return fastestRun * 1e3 / static_cast<double>( TestSignals::PROBE_LENGTH );
+}
+
+/* private methods */
+
+juce::AudioBuffer<float> RenderTest::render( int numInputChannels, int numOutputChannels, const BlockRenderer& renderBlock,
+                                             std::vector<double>* blockDurations, int maxBlockSize )
+{
+    auto probe = TestSignals::createProbe();
+
+    juce::AudioBuffer<float> output( numOutputChannels, TestSignals::PROBE_LENGTH );
+    juce::AudioBuffer<float> input ( numInputChannels,  maxBlockSize );
+    juce::AudioBuffer<float> block ( numOutputChannels, maxBlockSize );
+
+    for ( int offset = 0; offset < TestSignals::PROBE_LENGTH; offset += maxBlockSize ) {
+        int blockSize = std::min( maxBlockSize, TestSignals::PROBE_LENGTH - offset );
+
+        input.setSize( numInputChannels,  blockSize, false, false, true );
+        block.setSize( numOutputChannels, blockSize, false, false, true );
+        block.clear();
+
+        for ( int channel = 0; channel < numInputChannels; ++channel ) {
+            input.copyFrom( channel, 0, probe, channel, offset, blockSize );
+
+            if ( channel < numOutputChannels ) {
+                block.copyFrom( channel, 0, probe, channel, offset, blockSize );
+            }
+        }
+
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        {
+            REALTIME_SECTION();
+            renderBlock( input, block );
+        }
+
+        if ( blockDurations != nullptr ) {
+            blockDurations->push_back( juce::Time::highResolutionTicksToSeconds( juce::Time::getHighResolutionTicks() - startTicks ) * 1e6 );
+        }
+
+        for ( int channel = 0; channel < numOutputChannels; ++channel ) {
+            output.copyFrom( channel, offset, block, channel, 0, blockSize );
+        }
+    }
+    return output;
+}
+
+void RenderTest::expectMatchesReference( const juce::String& renderingName, const juce::AudioBuffer<float>& output, float tolerance )
+{
+    auto file = getReferenceFile( renderingName + ".wav" );
+    juce::WavAudioFormat format;
+
+    if ( updateReferences ) {
+        auto range = output.findMinMax( 0, 0, output.getNumSamples());
+
+        for ( int channel = 1; channel < output.getNumChannels(); ++channel ) {
+            range = range.getUnionWith( output.findMinMax( channel, 0, output.getNumSamples()));
+        }
+        expect( std::max( -range.getStart(), range.getEnd()) * REFERENCE_GAIN < 1.f, renderingName + " exceeds the range of its reference" );
+
+        juce::AudioBuffer<float> reference( output );
+        reference.applyGain( REFERENCE_GAIN );
+
+        file.deleteFile();
+
+        auto stream = std::make_unique<juce::FileOutputStream>( file );
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+
+        if ( stream->openedOk()) {
+            writer.reset( format.createWriterFor( stream.get(), TestSignals::SAMPLE_RATE, static_cast<unsigned int>( reference.getNumChannels()), 16, {}, 0 ));
+        }
+        if ( writer != nullptr ) {
+            stream.release(); // owned by the writer
+        }
+        expect( writer != nullptr && writer->writeFromAudioSampleBuffer( reference, 0, reference.getNumSamples()),
+                "could not write " + file.getFullPathName());
+        return;
+    }
+
+    std::unique_ptr<juce::AudioFormatReader> reader( format.createReaderFor( file.createInputStream().release(), true ));
+
+    if ( reader == nullptr ) {
+        expect( false, "no reference found at " + file.getFullPathName() + " (run the tests with --update-references)" );
+        return;
+    }
+
+    if ( static_cast<int>( reader->numChannels ) != output.getNumChannels() || reader->lengthInSamples != output.getNumSamples()) {
+        expect( false, renderingName + " differs in length or channel count from its reference" );
+        return;
+    }
+
+    juce::AudioBuffer<float> reference( output.getNumChannels(), output.getNumSamples());
+    reader->read( &reference, 0, reference.getNumSamples(), 0, true, true );
+    reference.applyGain( 1.f / REFERENCE_GAIN );
+
+    // report the largest deviation (invalid output, e.g. NaN, deviates infinitely)
+
+    float maxDeviation = 0.f;
+    int deviatingChannel = 0;
+    int deviatingFrame   = 0;
+
+    for ( int channel = 0; channel < output.getNumChannels(); ++channel ) {
+        const float* samples  = output.getReadPointer( channel );
+        const float* expected = reference.getReadPointer( channel );
+
+        for ( int i = 0; i < output.getNumSamples(); ++i ) {
+            float deviation = std::isfinite( samples[ i ]) ? std::abs( samples[ i ] - expected[ i ]) : std::numeric_limits<float>::infinity();
+
+            if ( deviation > maxDeviation ) {
+                maxDeviation     = deviation;
+                deviatingChannel = channel;
+                deviatingFrame   = i;
+            }
+        }
+    }
+    expect( maxDeviation <= tolerance, renderingName + " deviates " + juce::String( maxDeviation ) + " from its reference at frame "
+            + juce::String( deviatingFrame ) + " of channel " + juce::String( deviatingChannel ) + " (tolerance " + juce::String( tolerance ) + ")" );
+}
+
+void RenderTest::expectWithinBudget( const juce::String& renderingName, std::vector<double> blockDurations )
+{
+    std::sort( blockDurations.begin(), blockDurations.end());
+
+    double median = blockDurations[ blockDurations.size() / 2 ];
+    double worst  = blockDurations.back();
+    auto machineClass = getMachineClass();
+
+    logMessage( renderingName + ": " + juce::String( median, 1 ) + " us median, " + juce::String( worst, 1 )
+                + " us worst case per block of " + juce::String( BLOCK_SIZE ) + " samples (" + machineClass + ")" );
+
+    // the budgets are stored as lines of "<machine class> <rendering name> <microseconds per block>"
+
+    auto file = getReferenceFile( "budgets.txt" );
+    juce::StringArray lines;
+    lines.addLines( file.loadFileAsString());
+
+    auto key = machineClass + " " + renderingName + " ";
+    int index = -1;
+
+    for ( int i = 0; i < lines.size(); ++i ) {
+        if ( lines[ i ].startsWith( key )) {
+            index = i;
+        }
+    }
+
+    if ( updateBudgets ) {
+        auto line = key + juce::String( static_cast<int>( std::ceil( median * BUDGET_HEADROOM )));
+
+        if ( index >= 0 ) {
+            lines.set( index, line );
+        } else {
+            lines.add( line );
+        }
+        lines.removeEmptyStrings();
+        expect( file.replaceWithText( lines.joinIntoString( "\n" ) + "\n" ), "could not write " + file.getFullPathName());
+        return;
+    }
+
+    if ( index >= 0 ) {
+        double budget = lines[ index ].fromLastOccurrenceOf( " ", false, false ).getDoubleValue();
+        expect( median <= budget, renderingName + " exceeds its budget of " + juce::String( budget, 1 ) + " us per block" );
+        return;
+    }
+
+    if ( !checkDeadline ) {
+        logMessage( renderingName + ": no budget stored for " + machineClass + ", the time spent per block is not checked" );
+        return;
+    }
+
+#if !JUCE_DEBUG
+    double deadline = static_cast<double>( BLOCK_SIZE ) / TestSignals::SAMPLE_RATE * 1e6;
+    expect( median <= deadline, renderingName + " exceeds the real-time deadline of " + juce::String( deadline, 1 ) + " us per block" );
+#endif
+}
+
+juce::File RenderTest::getReferenceFile( const juce::String& fileName )
+{
+    return juce::File( DELIRION_TEST_REFERENCES ).getChildFile( fileName );
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <functional>
+#include <vector>
+#include "TestSignals.h"
+
+/**
+ * Base class of the tests rendering the probe (see TestSignals) through a module or the processor.
+ *
+ * Each rendering is made twice: offline, where its output is compared against a reference rendering checked in
+ * under tests/references (which is written instead when the runner is launched with --update-references), and
+ * in real-time, where the time spent per block is compared against the budget stored for the machine class
+ * running the test (see getMachineClass(), the budgets are written when launched with --update-budgets).
+ */
+class RenderTest : public juce::UnitTest
+{
+    public:
+        RenderTest( const juce::String& testName );
+
+        // the maximum deviation of any output sample from its reference (-60 dBFS), which accommodates the
+        // differences in floating point rounding between compilers, not in the algorithms. The references are
+        // rendered using the baseline kernels, as the wider instruction sets round differently (see getSimdLevel())
+
+        static constexpr float TOLERANCE = 1e-3f;
+
+        static constexpr int BLOCK_SIZE = 512;
+
+        // the references are stored as 16-bit at this gain, so output up to +12 dBFS is retained (the quantisation
+        // error remains well below the TOLERANCE). Budgets are stored with headroom for the variation between runs
+
+        static constexpr float REFERENCE_GAIN  = 0.25f;
+        static constexpr double BUDGET_HEADROOM = 2.0;
+        static const int MEASURED_RUNS = 4; // of the probe, when measuring the time spent per block
+
+        static bool updateReferences;
+        static bool updateBudgets;
+        static bool checkDeadline;
+
+        // the class of the machine running the tests, e.g. "x86_64-avx2-release". The time spent per block is
+        // only comparable between builds of the same type running the same kernels on the same architecture
+
+        static juce::String getMachineClass();
+
+    protected:
+        // renders a block of the probe, the output holds the input when invoked (its channels exceeding
+        // the amount of input channels are cleared)
+
+        using BlockRenderer = std::function<void( const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output )>;
+
+        // creates the renderer for an offline rendering (where the output must not depend on timing) or a real-time rendering
+
+        using RendererFactory = std::function<BlockRenderer( bool isOffline )>;
+
+        // the instruction set (see Simd) the kernels render with. Offline renderings use LEVEL_BASELINE as the wider
+        // levels fuse multiplications and additions, of which the rounding differences accumulate in the frozen reverbs
+        // (so the references hold on every CPU). Real-time renderings use the widest level supported by the CPU
+
+        static int getSimdLevel( bool isOffline );
+
+        // renders the probe offline and compares the output against the reference of given name, after which it is
+        // rendered in real-time and the median time spent per block is compared against the budget for given name.
+        // When no budget is stored for the machine class, the time is only checked when launched with --check-deadline
+        // (holding release builds to the real-time deadline, which depends on the load of the machine)
+
+        void expectRendering( const juce::String& renderingName, int numInputChannels, int numOutputChannels,
+                              const RendererFactory& createRenderer, float tolerance = TOLERANCE );
+
+        // renders the probe MEASURED_RUNS times in blocks of given size (e.g. the large blocks hosts provide when bouncing
+        // offline) and returns the time spent per sample (in ns) by the fastest run, as it is least affected by other
+        // activity on the system. The output of the first run is written into given output
+
+        double measureThroughput( int numInputChannels, int numOutputChannels, const BlockRenderer& renderBlock,
+                                  int blockSize, juce::AudioBuffer<float>& output );
+
+    private:
+        juce::AudioBuffer<float> render( int numInputChannels, int numOutputChannels, const BlockRenderer& renderBlock,
+                                         std::vector<double>* blockDurations = nullptr, int maxBlockSize = BLOCK_SIZE );
+
+        void expectMatchesReference( const juce::String& renderingName, const juce::AudioBuffer<float>& output, float tolerance );
+        void expectWithinBudget( const juce::String& renderingName, std::vector<double> blockDurations );
+
+        static juce::File getReferenceFile( const juce::String& fileName );
+};
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "RenderTest.h"
+
+/**
+ * Runs all tests headless, returning a non-zero exit code when any test failed. Launch with
+ * --update-references to write the reference renderings instead of comparing against them and with
+ * --update-budgets to store the time spent per block as the budgets of the machine class running the tests.
+ * Launch with --check-deadline to hold the renderings without a stored budget to the real-time deadline.
+ */
+int main( int argc, char* argv[] )
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser; // the processor requires a message manager (for its timer)
+    juce::ArgumentList arguments( argc, argv );
+
+    RenderTest::updateReferences = arguments.containsOption( "--update-references" );
+    RenderTest::updateBudgets    = arguments.containsOption( "--update-budgets" );
+    RenderTest::checkDeadline    = arguments.containsOption( "--check-deadline" );
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure( false );
+    runner.runTestsInCategory( "Delirion" );
+
+    int failures = 0;
+
+    for ( int i = 0; i < runner.getNumResults(); ++i ) {
+        failures += runner.getResult( i )->failures;
+    }
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2024 Igor Zinken https://www.igorski.nl
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+/**
+ * The fixed input rendered by the tests: a stereo probe of three consecutive segments holding a unit impulse,
+ * an exponential sine sweep and white noise. The channels differ (the impulse of the right channel is delayed,
+ * its sweep inverted and its noise uncorrelated) so channels that are mixed up are detected.
+ */
+namespace TestSignals
+{
+    static constexpr double SAMPLE_RATE = 44100.0;
+
+    static const int NUM_CHANNELS   = 2;
+    static const int SEGMENT_LENGTH = 8192; // long enough for the reverbs to freeze within the probe
+    static const int PROBE_LENGTH   = SEGMENT_LENGTH * 3;
+
+    static const int IMPULSE_OFFSET = 32; // of the right channel
+    static constexpr double SWEEP_START = 20.0;    // in Hz
+    static constexpr double SWEEP_END   = 20000.0; // in Hz
+    static constexpr float LEVEL = 0.5f;           // of the sweep and noise
+    static const int NOISE_SEED  = 0x646c7273;
+
+    inline juce::AudioBuffer<float> createProbe()
+    {
+        juce::AudioBuffer<float> probe( NUM_CHANNELS, PROBE_LENGTH );
+        probe.clear();
+
+        probe.setSample( 0, 0, 1.f );
+        probe.setSample( 1, IMPULSE_OFFSET, 1.f );
+
+        // the phase of the sweep is the integral of its exponentially rising frequency
+
+        double duration = static_cast<double>( SEGMENT_LENGTH ) / SAMPLE_RATE;
+        double rate     = std::log( SWEEP_END / SWEEP_START );
+
+        for ( int i = 0; i < SEGMENT_LENGTH; ++i ) {
+            double time  = static_cast<double>( i ) / SAMPLE_RATE;
+            double phase = juce::MathConstants<double>::twoPi * SWEEP_START * duration / rate * ( std::exp( time / duration * rate ) - 1.0 );
+            float sample = static_cast<float>( std::sin( phase )) * LEVEL;
+
+            probe.setSample( 0, SEGMENT_LENGTH + i,  sample );
+            probe.setSample( 1, SEGMENT_LENGTH + i, -sample );
+        }
+
+        juce::Random random( NOISE_SEED ); // so the noise is identical on each run
+
+        for ( int channel = 0; channel < NUM_CHANNELS; ++channel ) {
+            for ( int i = 0; i < SEGMENT_LENGTH; ++i ) {
+                probe.setSample( channel, SEGMENT_LENGTH * 2 + i, ( random.nextFloat() * 2.f - 1.f ) * LEVEL );
+            }
+        }
+        return probe;
+    }
+}